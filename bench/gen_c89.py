@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+# Generates large C89 programs using only the subset the compiler supports.
+# The output only depends on the arguments, so runs can be compared with each other.
+# --shape picks what the program is made of, to stress one part of the compiler at a time:
+#   functions    many small functions, a bit of everything (the default)
+#   expressions  a few functions of deep expression trees and long chains of operators
+#   calls        thousands of tiny functions, each calling ones before it
+#   globals      a lot of globals (one per 40 lines), read and written by every function
+#   scopes       deeply nested ifs, whiles and blocks, declaring variables at every level
+#   statements   a few functions with very long lists of statements
+#
+# usage: python3 bench/gen_c89.py --lines 100000 [--seed 1] [--shape functions] > big.c
+
+import argparse
+import random
+
+
+def expression(rng, names, depth):
+	# a random arithmetic / logical expression over the given variables
+	if depth <= 0 or rng.random() < 0.3:
+		if names and rng.random() < 0.6:
+			return rng.choice(names)
+		return str(rng.randint(0, 100))
+	op = rng.choice(["+", "-", "*", "&", "|", "^", "<", ">", "==", "!="])
+	return "(" + expression(rng, names, depth - 1) + " " + op + " " + expression(rng, names, depth - 1) + ")"
+
+
+def function(rng, index, out):
+	# writes one function of roughly 10 - 20 lines, returns the number of lines written
+	names = ["v%d" % i for i in range(rng.randint(2, 5))]
+	lines = ["int f%d(){" % index]
+	for n in names:
+		lines.append("\tint %s = %d;" % (n, rng.randint(0, 50)))
+	for _ in range(rng.randint(2, 6)):
+		kind = rng.random()
+		target = rng.choice(names)
+		if kind < 0.5:
+			lines.append("\t%s = %s;" % (target, expression(rng, names, 3)))
+		elif kind < 0.75:
+			lines.append("\tif(%s){" % expression(rng, names, 2))
+			lines.append("\t\t%s = %s;" % (target, expression(rng, names, 2)))
+			lines.append("\t}")
+		else:
+			lines.append("\twhile(%s < %d){" % (target, rng.randint(50, 200)))
+			lines.append("\t\t%s = %s + 1;" % (target, target))
+			lines.append("\t}")
+	lines.append("\treturn %s;" % expression(rng, names, 2))
+	lines.append("}")
+	lines.append("")
+	out.extend(lines)
+	return len(lines)
+
+
+def chain(rng, names, length):
+	# a flat run of operators, which the parser folds into one long left leaning tree
+	terms = [rng.choice(names) if rng.random() < 0.7 else str(rng.randint(0, 100)) for _ in range(length)]
+	out = terms[0]
+	for term in terms[1:]:
+		out += " " + rng.choice(["+", "-", "&", "|", "^"]) + " " + term
+	return out
+
+
+def expressions(rng, index, out):
+	names = ["v%d" % i for i in range(4)]
+	lines = ["int f%d(){" % index]
+	for n in names:
+		lines.append("\tint %s = %d;" % (n, rng.randint(0, 50)))
+	for _ in range(8):
+		target = rng.choice(names)
+		if rng.random() < 0.5:
+			lines.append("\t%s = %s;" % (target, expression(rng, names, 8)))
+		else:
+			lines.append("\t%s = %s;" % (target, chain(rng, names, 200)))
+	lines.append("\treturn %s;" % expression(rng, names, 4))
+	lines.append("}")
+	lines.append("")
+	out.extend(lines)
+	return len(lines)
+
+
+def calls(rng, index, out):
+	lines = ["int f%d(){" % index, "\tint v0 = %d;" % rng.randint(0, 50)]
+	for _ in range(rng.randint(1, 3)):
+		if index:
+			lines.append("\tv0 = v0 + f%d();" % rng.randint(max(0, index - 50), index - 1))
+	lines.append("\treturn v0;")
+	lines.append("}")
+	lines.append("")
+	out.extend(lines)
+	return len(lines)
+
+
+def globals_user(rng, index, out, globals_):
+	# a function that reads and writes globals, with a local or two mixed in
+	names = ["v0", "v1"] + rng.sample(globals_, 6)
+	lines = ["int f%d(){" % index, "\tint v0 = %d;" % rng.randint(0, 50), "\tint v1 = %d;" % rng.randint(0, 50)]
+	for _ in range(30):
+		lines.append("\t%s = %s;" % (rng.choice(names), expression(rng, names, 2)))
+	lines.append("\treturn %s;" % expression(rng, names, 2))
+	lines.append("}")
+	lines.append("")
+	out.extend(lines)
+	return len(lines)
+
+
+def nested(rng, names, depth, indent, lines):
+	# a block inside a block inside a block, each level with a variable of its own
+	name = "d%d" % depth
+	lines.append(indent + "int %s = %s;" % (name, expression(rng, names, 1)))
+	names = names + [name]
+	lines.append(indent + "%s = %s;" % (rng.choice(names), expression(rng, names, 2)))
+	if depth >= 24:
+		return
+	kind = rng.random()
+	if kind < 0.4:
+		lines.append(indent + "if(%s){" % expression(rng, names, 1))
+	elif kind < 0.7:
+		lines.append(indent + "while(%s < %d){" % (name, rng.randint(50, 200)))
+	else:
+		lines.append(indent + "{")
+	nested(rng, names, depth + 1, indent + "\t", lines)
+	if 0.4 <= kind < 0.7:  # after the inner block, since declarations have to come first
+		lines.append(indent + "\t%s = %s + 1;" % (name, name))
+	lines.append(indent + "}")
+
+
+def scopes(rng, index, out):
+	lines = ["int f%d(){" % index, "\tint v0 = %d;" % rng.randint(0, 50)]
+	nested(rng, ["v0"], 0, "\t", lines)
+	lines.append("\treturn v0;")
+	lines.append("}")
+	lines.append("")
+	out.extend(lines)
+	return len(lines)
+
+
+def statements(rng, index, out):
+	names = ["v%d" % i for i in range(6)]
+	lines = ["int f%d(){" % index]
+	for n in names:
+		lines.append("\tint %s = %d;" % (n, rng.randint(0, 50)))
+	for _ in range(2000):
+		lines.append("\t%s = %s;" % (rng.choice(names), expression(rng, names, 1)))
+	lines.append("\treturn %s;" % rng.choice(names))
+	lines.append("}")
+	lines.append("")
+	out.extend(lines)
+	return len(lines)
+
+
+SHAPES = ["functions", "expressions", "calls", "globals", "scopes", "statements"]
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--lines", type=int, default=100000)
+	parser.add_argument("--seed", type=int, default=1)
+	parser.add_argument("--shape", choices=SHAPES, default="functions")
+	args = parser.parse_args()
+
+	rng = random.Random(args.seed)
+	out = []
+	written = 0
+	index = 0
+	make = {
+		"functions": function,
+		"expressions": expressions,
+		"calls": calls,
+		"scopes": scopes,
+		"statements": statements,
+	}.get(args.shape)
+	if args.shape == "globals":
+		# one global for every 40 lines, all declared first so that any function can use any of them
+		globals_ = ["g%d" % i for i in range(max(8, args.lines // 40))]
+		for g in globals_:
+			out.append("int %s = %d;" % (g, rng.randint(0, 50)))
+		written = len(out)
+		make = lambda rng, index, out: globals_user(rng, index, out, globals_)
+	while written < args.lines:
+		written += make(rng, index, out)
+		index += 1
+	print("\n".join(out))
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,86 @@
+#!/bin/bash
+# Lexer throughput in MB/s of source, for comparing two builds of the compiler, e.g. one from
+# before the lexer read the whole file into one buffer (src/source.hpp) and one from after.
+# Each input is run through --translate with --time-report=json, and only the "lex" phase of the
+# report is counted, so parsing and writing the python do not get in the way. A build too old to have
+# --time-report is timed over the whole --translate run instead, and marked with a * in the output.
+# Each size is run three times and the fastest kept.
+#
+# usage: bench/lex_throughput.sh --old old_compiler [--new new_compiler] [--lines N] ...   run from the top of the repo
+#   --new defaults to bin/c_compiler. --lines can be given more than once, and defaults to 100000 and
+#   300000 (roughly 1.5MB and 4.5MB)
+
+usage(){
+    >&2 echo "usage: bench/lex_throughput.sh --old old_compiler [--new new_compiler] [--lines N] ..."
+    exit 1
+}
+
+OLD=
+NEW=bin/c_compiler
+SIZES=
+while [[ $# -gt 0 ]]; do
+    case $1 in
+        --old) OLD=$2; shift 2 ;;
+        --new) NEW=$2; shift 2 ;;
+        --lines) SIZES="${SIZES} $2"; shift 2 ;;
+        *) >&2 echo "ERROR : unexpected argument $1"; usage ;;
+    esac
+done
+if [[ -z "${OLD}" || -z "${NEW}" ]]; then
+    usage
+fi
+SIZES=${SIZES:-100000 300000}
+for COMPILER in ${OLD} ${NEW}; do
+    if [[ ! -x ${COMPILER} ]]; then
+        >&2 echo "ERROR : ${COMPILER} is not an executable"
+        exit 1
+    fi
+done
+for SIZE in ${SIZES}; do
+    if ! [[ ${SIZE} =~ ^[0-9]+$ ]]; then
+        >&2 echo "ERROR : --lines takes a number, not ${SIZE}"
+        exit 1
+    fi
+done
+WORK=bench/work
+mkdir -p ${WORK}
+
+TIMEFORMAT=%R
+seconds(){ # compiler, input. Prints how long one run spent lexing, or the whole run followed by * if it cannot say
+    REPORT=$( $1 --translate $2 -o /dev/null --time-report=json 2>&1 > /dev/null | tail -n 1 )
+    NANOS=$(echo "${REPORT}" | sed -n 's/.*"lex":\([0-9]*\).*/\1/p')
+    if [[ -n "${NANOS}" ]]; then
+        awk "BEGIN{printf \"%.6f\", ${NANOS} / 1e9}"
+    else
+        echo "$( { time $1 --translate $2 -o /dev/null > /dev/null 2>&1 ; } 2>&1 )*"
+    fi
+}
+best(){ # compiler, input. Prints the fastest of three runs
+    BEST=
+    for RUN in 1 2 3; do
+        SECS=$(seconds $1 $2)
+        if [[ -z "${BEST}" ]] || awk "BEGIN{exit !(${SECS%\*} < ${BEST%\*})}"; then
+            BEST=${SECS}
+        fi
+    done
+    echo ${BEST}
+}
+rate(){ # MB, seconds (maybe marked). Prints MB/s, with the mark kept
+    MARK=
+    [[ $2 == *\* ]] && MARK="*"
+    awk "BEGIN{printf \"%.2f%s\", $1 / ${2%\*}, \"${MARK}\"}"
+}
+
+echo "input, size, old MB/s, new MB/s"
+for LINES in ${SIZES}; do
+    INPUT=${WORK}/lex_input_${LINES}.c
+    python3 bench/gen_c89.py --lines ${LINES} > ${INPUT} || exit 1
+    BYTES=$(wc -c < ${INPUT})
+    MB=$(awk "BEGIN{printf \"%.2f\", ${BYTES} / 1048576}")
+    ROW="${LINES} lines, ${MB}MB, $(rate ${MB} $(best ${OLD} ${INPUT})), $(rate ${MB} $(best ${NEW} ${INPUT}))"
+    echo "${ROW}"
+    [[ ${ROW} == *\** ]] && MARKED=1
+done
+if [[ -n "${MARKED}" ]]; then
+    echo "* no --time-report in that build, so the whole --translate run"
+fi
@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+# How good the generated code is, measured rather than guessed: each test case in
+# test_deliverable/test_cases is compiled, linked with its driver as test_bench.sh does, and run under
+# qemu-mips with its translation log on (-d in_asm,exec,nochain -D file, which any qemu can do without
+# plugins). The log has the instructions of every block qemu translated and a line each time a block
+# ran, so together they give, for the compiled functions only (not the driver or libc):
+#   dynamic      instructions executed
+#   loads        lb, lh, lw and the like executed
+#   stores       sb, sh, sw and the like executed
+#   branches     branches and jumps executed
+#   nops         nops executed, mostly unfilled delay slots
+# and, from the linked program,
+#   static       instructions in the compiled functions, from their sizes. Not .text, which the
+#                assembler may pad
+# These are compared with bench/mips_baseline.json, and it fails (exit 1) if any has gone up by more
+# than --threshold percent (0 by default, since the counts are exact). Without a baseline it fails as
+# well, rather than quietly taking whatever this run measures. --update writes it. A test case the
+# compiler cannot handle is listed as skipped and left out.
+#
+# Needs mips-linux-gnu-gcc (and its binutils) and qemu-mips, nothing else.
+#
+# usage: python3 bench/mips_counts.py [--compiler bin/c_compiler] [--baseline bench/mips_baseline.json]
+#                                     [--threshold 0] [--update] [--gcc mips-linux-gnu-gcc] [--qemu qemu-mips]
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TESTS = os.path.join(HERE, "..", "test_deliverable", "test_cases")
+METRICS = ["dynamic", "loads", "stores", "branches", "nops", "static"]
+
+LOADS = {"lb", "lbu", "lh", "lhu", "lw", "lwl", "lwr", "ll", "lwc1", "ldc1"}
+STORES = {"sb", "sh", "sw", "swl", "swr", "sc", "swc1", "sdc1"}
+
+TB_START = re.compile(r"^IN:")
+INSTRUCTION = re.compile(r"^0x([0-9a-f]+):\s+(?:[0-9a-f]{8}\s+)?([a-z][a-z0-9.]*)")
+EXECUTED = re.compile(r"^Trace (?:\d+: )?0x[0-9a-f]+ \[(?:\d+: )?([0-9a-fx/]+)\]")  # the format has changed between versions
+
+
+def is_branch(mnemonic):
+	return (mnemonic[0] in "bj" and mnemonic != "break") or mnemonic in {"jr", "jalr"}
+
+
+def count_log(log, ranges):
+	# counts from a qemu in_asm,exec log, only for instructions inside ranges, a list of (start, end)
+	blocks = {}  # start of a translated block to the instructions in it
+	executions = {}  # start of a block to how many times it ran
+	current = None
+	with open(log, errors="replace") as f:
+		for line in f:
+			if TB_START.match(line):
+				current = []
+				continue
+			match = INSTRUCTION.match(line)
+			if match and current is not None:
+				if not current:
+					blocks[int(match.group(1), 16)] = current
+				current.append((int(match.group(1), 16), match.group(2)))
+				continue
+			if not line.strip():
+				current = None
+				continue
+			match = EXECUTED.match(line)
+			if match:
+				fields = match.group(1).split("/")  # [pc], or [cpu or cs_base/pc/flags...]
+				pc = int(fields[1] if len(fields) > 1 else fields[0], 16)
+				executions[pc] = executions.get(pc, 0) + 1
+	counts = dict((m, 0) for m in METRICS if m != "static")
+	for pc, times in executions.items():
+		for address, mnemonic in blocks.get(pc, []):
+			if not any(start <= address < end for start, end in ranges):
+				continue
+			counts["dynamic"] += times
+			if mnemonic in LOADS:
+				counts["loads"] += times
+			elif mnemonic in STORES:
+				counts["stores"] += times
+			elif mnemonic == "nop":
+				counts["nops"] += times
+			elif is_branch(mnemonic):
+				counts["branches"] += times
+	return counts
+
+
+def function_ranges(tools, elf, assembly):
+	# where the functions defined in assembly ended up in elf. Each is as long as nm -S says, which the
+	# assembler takes from .ent / .end. Without a size it runs up to the next global function, since
+	# local labels (and the driver's static functions) can sit inside or between them
+	with open(assembly) as f:
+		names = set(re.findall(r"^\s*\.globl\s+(\S+)", f.read(), re.M))
+	functions = []  # (address, size or None, name) of every global text symbol, in address order
+	output = subprocess.check_output([tools["nm"], "-n", "-S", "--defined-only", elf], universal_newlines=True)
+	for line in output.splitlines():
+		parts = line.split()
+		if len(parts) == 4 and parts[2] == "T":
+			functions.append((int(parts[0], 16), int(parts[1], 16), parts[3]))
+		elif len(parts) == 3 and parts[1] == "T":
+			functions.append((int(parts[0], 16), None, parts[2]))
+	ranges = []
+	for i, (address, size, name) in enumerate(functions):
+		if name not in names:
+			continue
+		if size is None:
+			size = functions[i + 1][0] - address if i + 1 < len(functions) else 0
+		ranges.append((address, address + size))
+	return ranges
+
+
+def measure(tools, compiler, name, work):
+	# the counts for one test case, or a reason it was skipped
+	driver = os.path.join(TESTS, name + "_driver.c")
+	source = os.path.join(TESTS, name + ".c")
+	base = os.path.join(work, name)
+	steps = [
+		("driver does not compile", [tools["gcc"], "-c", driver, "-o", base + "_driver.o"]),
+		("compiler failed", [compiler, "-S", source, "-o", base + ".s"]),
+		("does not assemble", [tools["gcc"], "-c", base + ".s", "-o", base + ".o"]),
+		("does not link", [tools["gcc"], "-static", base + ".o", base + "_driver.o", "-o", base + ".elf"]),
+	]
+	for reason, command in steps:
+		if subprocess.call(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL) != 0:
+			return reason
+	log = base + ".qemu.log"
+	if subprocess.call([tools["qemu"], "-d", "in_asm,exec,nochain", "-D", log, base + ".elf"],
+			stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL) != 0:
+		return "wrong answer"
+	ranges = function_ranges(tools, base + ".elf", base + ".s")
+	counts = count_log(log, ranges)
+	counts["static"] = sum(end - start for start, end in ranges) // 4
+	os.remove(log)  # they can be large, and are only needed for the counts
+	return counts
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--compiler", default="bin/c_compiler")
+	parser.add_argument("--baseline", default=os.path.join(HERE, "mips_baseline.json"))
+	parser.add_argument("--threshold", type=float, default=0, help="percent")
+	parser.add_argument("--update", action="store_true", help="write the baseline instead of checking it")
+	parser.add_argument("--gcc", default="mips-linux-gnu-gcc")
+	parser.add_argument("--qemu", default="qemu-mips")
+	args = parser.parse_args()
+
+	prefix = args.gcc[:-3] if args.gcc.endswith("gcc") else ""
+	tools = {"gcc": args.gcc, "qemu": args.qemu, "nm": prefix + "nm"}
+	missing = [tool for tool in sorted(tools.values()) + [args.compiler] if shutil.which(tool) is None]
+	if missing:
+		sys.exit("ERROR : %s not found" % ", ".join(missing))
+	work = os.path.join(HERE, "work", "mips")
+	os.makedirs(work, exist_ok=True)
+
+	baseline = {}
+	if not args.update:
+		if not os.path.exists(args.baseline):
+			sys.exit("ERROR : no baseline at %s. Run with --update to record one" % args.baseline)
+		with open(args.baseline) as f:
+			baseline = json.load(f)
+
+	results = {}
+	worse = []
+	print("%-16s" % "test" + "".join("%10s" % m for m in METRICS))
+	for driver in sorted(glob.glob(os.path.join(TESTS, "*_driver.c"))):
+		name = os.path.basename(driver)[:-len("_driver.c")]
+		counts = measure(tools, args.compiler, name, work)
+		if not isinstance(counts, dict):
+			print("%-16s skipped, %s" % (name, counts))
+			continue
+		results[name] = counts
+		before = baseline.get(name, {})
+		print("%-16s" % name + "".join("%10d" % counts[m] for m in METRICS))
+		changes = []
+		for m in METRICS:
+			if m in before and counts[m] != before[m]:
+				changes.append("%s %+d" % (m, counts[m] - before[m]))
+				if counts[m] > before[m] * (1 + args.threshold / 100.0):
+					worse.append("%s %s: %d -> %d" % (name, m, before[m], counts[m]))
+		if changes:
+			print("%-16s (%s against the baseline)" % ("", ", ".join(changes)))
+	totals = dict((m, sum(r[m] for r in results.values())) for m in METRICS)
+	print("%-16s" % "TOTAL" + "".join("%10d" % totals[m] for m in METRICS))
+
+	if args.update:
+		with open(args.baseline, "w") as f:
+			json.dump(results, f, indent=1, sort_keys=True)
+			f.write("\n")
+		print("baseline written to %s" % args.baseline)
+		return 0
+	for name in sorted(set(baseline) - set(results)):
+		worse.append("%s: in the baseline, but skipped now" % name)
+	if worse:
+		print("worse than the baseline by more than %g%%:" % args.threshold)
+		for line in worse:
+			print("  " + line)
+		return 1
+	print("nothing worse than the baseline by more than %g%%" % args.threshold)
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
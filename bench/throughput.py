@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# Compiler throughput on large generated programs, checked against a stored baseline (make bench).
+#
+# Every shape gen_c89.py knows is generated once (the same program every time) and compiled with -S and
+# with --translate. For each, it records
+#   lines_per_s, tokens_per_s   from the fastest of --runs runs, tokens counted by --time-report
+#   peak_rss_kb                 the compiler's maximum resident set, from wait4
+#   output_bytes                the size of what it wrote
+# and compares them with the baseline. It fails (exit 1) if a speed has dropped, or the memory or output
+# size has grown, by more than --threshold percent. The first run, or --update, writes the baseline.
+# Speeds depend on the machine, so a baseline is only meaningful on the one that made it.
+#
+# usage: python3 bench/throughput.py [--compiler bin/c_compiler] [--baseline bench/baseline.json]
+#                                    [--threshold 10] [--lines 20000] [--runs 3] [--update]
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, HERE)
+from gen_c89 import SHAPES  # noqa: E402
+
+MODES = [("-S", ".s"), ("--translate", ".py")]
+HIGHER_IS_BETTER = ["lines_per_s", "tokens_per_s"]
+LOWER_IS_BETTER = ["peak_rss_kb", "output_bytes"]
+
+
+def run(command):
+	# runs the compiler, returns (seconds, peak rss in kB, stderr)
+	start = time.perf_counter()
+	process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+	stderr = process.stderr.read()
+	_, status, usage = os.wait4(process.pid, 0)
+	seconds = time.perf_counter() - start
+	process.returncode = os.waitstatus_to_exitcode(status)  # so Popen does not wait for it again
+	if process.returncode != 0:
+		sys.exit("ERROR : %s failed\n%s" % (" ".join(command), stderr.decode(errors="replace")))
+	return seconds, usage.ru_maxrss, stderr.decode(errors="replace")
+
+
+def measure(compiler, source, mode, ext, runs):
+	output = source[:-2] + ext
+	command = [compiler, mode, source, "-o", output]
+	best = None
+	rss = 0
+	for _ in range(runs):
+		seconds, peak, _ = run(command)
+		best = seconds if best is None else min(best, seconds)
+		rss = max(rss, peak)
+	# once more to count the tokens. Not timed, since the report reads the clock for every token
+	_, _, stderr = run(command + ["--time-report=json"])
+	tokens = json.loads(stderr.strip().splitlines()[-1])["counts"]["tokens"]
+	with open(source) as f:
+		lines = sum(1 for _ in f)
+	return {
+		"lines_per_s": round(lines / best),
+		"tokens_per_s": round(tokens / best),
+		"peak_rss_kb": rss,
+		"output_bytes": os.path.getsize(output),
+	}
+
+
+def regressions(name, now, before, threshold):
+	found = []
+	for metric in HIGHER_IS_BETTER + LOWER_IS_BETTER:
+		if metric not in before or before[metric] == 0:
+			continue
+		change = 100.0 * (now[metric] - before[metric]) / before[metric]
+		if (metric in HIGHER_IS_BETTER and change < -threshold) or (metric in LOWER_IS_BETTER and change > threshold):
+			found.append("%s %s: %d -> %d (%+.1f%%)" % (name, metric, before[metric], now[metric], change))
+	return found
+
+
+def main():
+	parser = argparse.ArgumentParser()
+	parser.add_argument("--compiler", default="bin/c_compiler")
+	parser.add_argument("--baseline", default=os.path.join(HERE, "baseline.json"))
+	parser.add_argument("--threshold", type=float, default=10, help="percent")
+	parser.add_argument("--lines", type=int, default=20000, help="of each generated program")
+	parser.add_argument("--runs", type=int, default=3)
+	parser.add_argument("--update", action="store_true", help="write the baseline instead of checking it")
+	args = parser.parse_args()
+
+	work = os.path.join(HERE, "work")
+	os.makedirs(work, exist_ok=True)
+	results = {}
+	print("%-24s %12s %12s %12s %12s" % ("benchmark", "lines/s", "tokens/s", "peak RSS kB", "output B"))
+	for shape in SHAPES:
+		source = os.path.join(work, "bench_%s.c" % shape)
+		with open(source, "w") as f:
+			subprocess.check_call([sys.executable, os.path.join(HERE, "gen_c89.py"), "--lines", str(args.lines), "--shape", shape], stdout=f)
+		for mode, ext in MODES:
+			name = "%s %s" % (shape, mode)
+			result = measure(args.compiler, source, mode, ext, args.runs)
+			results[name] = result
+			print("%-24s %12d %12d %12d %12d" % (name, result["lines_per_s"], result["tokens_per_s"], result["peak_rss_kb"], result["output_bytes"]))
+
+	if args.update or not os.path.exists(args.baseline):
+		with open(args.baseline, "w") as f:
+			json.dump({"lines": args.lines, "results": results}, f, indent=1, sort_keys=True)
+			f.write("\n")
+		print("baseline written to %s" % args.baseline)
+		return 0
+
+	with open(args.baseline) as f:
+		baseline = json.load(f)
+	if baseline.get("lines") != args.lines:
+		sys.exit("ERROR : the baseline is for %s line programs, not %d. Use --update to replace it" % (baseline.get("lines"), args.lines))
+	found = []
+	for name, result in results.items():
+		if name in baseline["results"]:
+			found += regressions(name, result, baseline["results"][name], args.threshold)
+	if found:
+		print("regressions of more than %g%% against %s:" % (args.threshold, args.baseline))
+		for line in found:
+			print("  " + line)
+		return 1
+	print("no regressions of more than %g%% against %s" % (args.threshold, args.baseline))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Measures what the debug tracing costs on a large (100k line by default) input.
+# Builds the compiler twice, once with tracing compiled in and once with TRACE=0, then times
+#   traced build with -vvv   (everything printed, the same amount of output the old unconditional std::cerr gave)
+#   traced build, no flags    (tracing compiled in but switched off at run time)
+#   TRACE=0 build             (tracing compiled out)
+#
+# usage: bench/trace_overhead.sh [lines]   run from the top of the repo
+
+LINES=${1:-100000}
+WORK=bench/work
+mkdir -p ${WORK}
+
+python3 bench/gen_c89.py --lines ${LINES} > ${WORK}/trace_input.c || exit 1
+
+make -B TRACE=1 bin/c_compiler > ${WORK}/build.log 2>&1 || { >&2 echo "ERROR : build failed, see ${WORK}/build.log"; exit 1; }
+cp bin/c_compiler ${WORK}/c_compiler_trace
+make -B TRACE=0 bin/c_compiler >> ${WORK}/build.log 2>&1 || { >&2 echo "ERROR : build failed, see ${WORK}/build.log"; exit 1; }
+cp bin/c_compiler ${WORK}/c_compiler_notrace
+
+TIMEFORMAT=%R
+run(){ # name, then the command
+    NAME=$1
+    shift
+    SECS=$( { time "$@" > /dev/null 2> ${WORK}/trace_stderr.txt ; } 2>&1 )
+    echo "${NAME}, ${SECS}s, $(wc -l < ${WORK}/trace_stderr.txt) trace lines"
+}
+
+echo "$(wc -l < ${WORK}/trace_input.c) line input"
+run "trace compiled in, -vvv" ${WORK}/c_compiler_trace -vvv -S ${WORK}/trace_input.c -o ${WORK}/trace_output.s
+run "trace compiled in, off" ${WORK}/c_compiler_trace -S ${WORK}/trace_input.c -o ${WORK}/trace_output.s
+run "trace compiled out" ${WORK}/c_compiler_notrace -S ${WORK}/trace_input.c -o ${WORK}/trace_output.s
@@ -4,12 +4,6 @@
 
 #include <string>
 
-extern int myGlobVarbCounter;
-
-extern std::vector<std::string> myGlobVarbContainer;
-
-extern int unique_name;
-
 class FunctionDecl : public Node {
 	protected:
 		std::string ret_type; // string containing what the return type is
@@ -18,20 +12,24 @@ class FunctionDecl : public Node {
 		NodePtr args; // pointer to a parameter list
 		bool isMain; // we need to be able to create a valid main entry point. As such, a boolean tracking if this is the main function
 		int myDecls; // we need to record how many variables are declared in this function
+		const std::vector<Symbol> &globals; // every global in the file, the session's list. Only complete once the whole file is parsed
+		SourceSpan source; // where it is in the file
 	public: 
 		//constructor without arguments list
-		FunctionDecl(std::string _ret, std::string _ID, NodePtr _body) : 
+		FunctionDecl(std::string _ret, std::string _ID, NodePtr _body, const std::vector<Symbol> &_globals, const SourceSpan &_source) : 
 			ret_type(_ret),
 			fnc_ID(_ID),
 			body(_body),
-			args(NULL)
+			args(NULL),
+			globals(_globals),
+			source(_source)
 		
 			{
-				std::cerr<<"Constructor for func decl"<<std::endl;
+				TRACE(TRACE_PARSER, TRACE_DEBUG, "Constructor for func decl");
 				myDecls=0;
 				if(fnc_ID=="main"){
 					isMain=true;
-					std::cerr<<"Just made the main"<<std::endl;
+					TRACE(TRACE_PARSER, TRACE_DEBUG, "Just made the main");
 				}
 				else{
 					isMain=false;
@@ -41,23 +39,25 @@ class FunctionDecl : public Node {
 				body->explore(explore_v,explore_m);
 
 				myDecls=explore_v;
-				std::cerr<<"I am function "<<fnc_ID<<" I explored myself and found "<<myDecls<<"Decls inside of me"<<std::endl;
+				TRACE(TRACE_EXPLORE, TRACE_INFO, "I am function "<<fnc_ID<<" I explored myself and found "<<myDecls<<"Decls inside of me");
 
 			}
 			
 		//constructor with arguments list
 		//going to need to use special case with $4 - $7
-		FunctionDecl(std::string _ret, std::string _ID, NodePtr _body, NodePtr _args) : 
+		FunctionDecl(std::string _ret, std::string _ID, NodePtr _body, NodePtr _args, const std::vector<Symbol> &_globals, const SourceSpan &_source) : 
 			ret_type(_ret),
 			fnc_ID(_ID),
 			body(_body),
-			args(_args)
+			args(_args),
+			globals(_globals),
+			source(_source)
 			
 		{
-			std::cerr<<"Constructor for func decl with parameters"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Constructor for func decl with parameters");
 			if(fnc_ID=="main"){
 				isMain=true;
-				std::cerr<<"Just made the main"<<std::endl;
+				TRACE(TRACE_PARSER, TRACE_DEBUG, "Just made the main");
 			}
 			else{
 				isMain=false;
@@ -69,12 +69,15 @@ class FunctionDecl : public Node {
 			Context explore_m; // currently empty
 			body->explore(explore_v,explore_m);
 			myDecls=explore_v;
-			std::cerr<<"I am function "<<fnc_ID<<" I explored myself and found "<<myDecls<<"Decls inside of me"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_INFO, "I am function "<<fnc_ID<<" I explored myself and found "<<myDecls<<"Decls inside of me");
 			
 		}
 		
+		const std::string &name() const { return fnc_ID; }
+		const SourceSpan &where() const { return source; }
+
 		virtual void print(std::ostream &dst) const override {
-			std::cerr<<"I am trying to print the func declr"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "I am trying to print the func declr");
 			dst<<ret_type;
 			dst<<" ";
 			dst<<fnc_ID;
@@ -88,55 +91,71 @@ class FunctionDecl : public Node {
 
 		virtual void translate(std::ostream &dst, int indent) const override {
 		
-			std::cerr<<"_____dec1_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____dec1_____");
 			dst<<"def "<<fnc_ID<<"(";
-			std::cerr<<"_____dec2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____dec2_____");
 			if(args!=NULL){
 				args->translate(dst, indent);
 			}
 			dst<<"):"<<std::endl;
-			std::cerr<<"_____dec3_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____dec3_____");
+			if(!globals.empty()){ // python needs to be told once, at the top of the function, which names are global
+				TRACE(TRACE_TRANSLATE, TRACE_DEBUG, "There were some global variables to translate");
+				for (size_t i=0; i<globals.size();i++){
+					for(int j=0; j<indent+4;j++){//Shold make a function / member function, quick hack for now
+						dst<<" ";
+					}
+					dst<<"global "<<globals[i].name()<<std::endl;
+				}
+			}
 			body->translate(dst,indent+4);
-			std::cerr<<"_____dec4_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____dec4_____");
 			
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		
-		
-			if(myGlobVarbCounter!=0){
-				std::cerr<<"There are some global variables to consider."<<std::endl;
-				for(int i=1; i<myGlobVarbContainer.size();i=i+2){
-					std::cerr<<"Found a global called "<<myGlobVarbContainer[i]<<std::endl;
-					bindings.growGlobals(myGlobVarbContainer[i]);			
-							
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			// globals were bound once, in the root scope, by DeclGlobal::compile. Only this function's own names go in its scope
+			bindings.enterScope(); // everything bound in here is forgotten at the end of the function
+			if(TRACE_ON(TRACE_CODEGEN, TRACE_NOISE)){
+				bindings.dumpTable();
+			}
+
+			// the body is built up in virtual registers first. Nothing is printed until registers have been allocated
+			TimeReport *times = bindings.times();
+			FunctionCode fn(fnc_ID);
+			fn.emitIR = code.emitIR;
+			fn.returnLabel = fn.labelSymbol("$returnLable",fn.newLabel());
+			{
+				PhaseTimer codegen(times,PHASE_CODEGEN);
+				if(args!=NULL){
+					args->compile(dst,bindings,fn,NO_REG,fn.returnLabel);
 				}
-			
+				body->compile(dst,bindings,fn,NO_REG,fn.returnLabel);
+				fn.label(fn.returnLabel);
 			}
-			bindings.dumpTable();
-		
-			dst<<"	.globl	"<<fnc_ID<<std::endl;
-			dst<<"	.ent	"<<fnc_ID<<std::endl;
-			dst<<fnc_ID<<":"<<std::endl;
-			
-			std::string returnLable = "$returnLable" + std::to_string(unique_name);
-			unique_name++;
-			
-			std::cerr<<"DEBUG, myDECLS is "<<myDecls<<std::endl;
-			int stackAllocate = 8 + 4*myDecls;//dynamically work out how much stack to allocate
-			dst<<"addiu $sp,$sp,-"<<stackAllocate <<std::endl; //allocate stack
-			dst<<"sw $fp,"<<(stackAllocate-4)<<"($sp)"<<std::endl; //the location of the old frame pointer is 4 less the top of the stack
-			dst<<"move	$fp,$sp"<<std::endl;			
-			if(args!=NULL){
-				args->compile(dst, bindings, regs,destReg,returnLable);
+			{
+				PhaseTimer passes(times,PHASE_PASSES);
+				Peephole peephole(fn);
+				peephole.run(); // tidies up after the nodes, while every temporary still has its own register
+				bindings.countPeephole(peephole.counts());
+				if(!fn.emitIR){
+					RegisterAllocator(fn).run(); // also adds the prologue and epilogue, now the frame size is known
+					Scheduler(fn).run(); // fills delay slots
+				}
+			}
+			{
+				PhaseTimer output(times,PHASE_OUTPUT);
+				if(fn.emitIR){ // stop here and show what the back end would be given
+					ControlFlowGraph(fn).print(dst);
+				}
+				else{
+					MipsEmitter::function(dst,fn);
+				}
+			}
+			if(times){
+				times->count(TALLY_FUNCTIONS,1);
+				times->count(TALLY_INSTRUCTIONS,fn.instrs.size());
 			}
-			body->compile(dst, bindings, regs,destReg,returnLable);
-			dst<<returnLable<<":"<<std::endl;
-			dst<<"move $sp,$fp" << std::endl; // boiler plate
-			dst<<"lw $fp,"<<(stackAllocate-4)<<"($sp)"<<std::endl; //the location of the old frame pointer is 4 less the top of the stack
-			dst<<"addiu $sp,$sp,"<<stackAllocate <<std::endl; // restore stack pointer
-			dst<<"j $31"<<std::endl;
-			dst<<"nop"<<std::endl;			
-			dst<<"	.end	"<<fnc_ID<<std::endl;			
+			bindings.leaveScope();
 		}	//may be an idea to make sure stuff can point to parent
 			//or at least the capability to count up a glob var
 		virtual void explore(int & declarations, Context & bindings) const  override{
@@ -153,22 +172,22 @@ class Param : public Node{
 
 	protected:
 		std::string type;
-		std::string id;
+		Symbol id;
 		//ExpresstionPtr value; // technically this is valid eg int f(int x=2){return x;} is a valid function, returning 2 or the input. Not going to be supported.
 	public:
-		Param (std::string _type, std::string _id) : type(_type), id(_id){} //constructor
+		Param (std::string _type, Symbol _id) : type(_type), id(_id){} //constructor
 		virtual void print(std::ostream &dst) const override {
 			
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
-			dst<<id;
+			dst<<id.name();
 				
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			std::cerr<<"Parameter Compilation not implemented"<<std::endl;
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			TRACE(TRACE_CODEGEN, TRACE_INFO, "Parameter Compilation not implemented");
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"Parameter Exploration unimplemented"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_DEBUG, "Parameter Exploration unimplemented");
 		}
 };
 
@@ -186,21 +205,21 @@ class ParamList : public Node{ // list of function paramaters
 		}
 		
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____paramLIST1_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____paramLIST1_____");
 			if(next!=NULL){				
 				next->translate(dst,indent);
 				dst<<", ";
 			}
-			std::cerr<<"_____paramLIST2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____paramLIST2_____");
 			current->translate(dst,indent);
-			std::cerr<<"_____paramLIST3_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____paramLIST3_____");
 				
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			std::cerr<<"Parameter List Compilation unimplemented"<<std::endl;
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			TRACE(TRACE_CODEGEN, TRACE_INFO, "Parameter List Compilation unimplemented");
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"Parameter List Exploration unimplemented"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_DEBUG, "Parameter List Exploration unimplemented");
 		}
 };
 
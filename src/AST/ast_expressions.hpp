@@ -3,84 +3,80 @@
 #ifndef ast_expressions_hpp
 #define ast_expressions_hpp
 
-extern int unique_name;
 
 class Expression : public Node {
+	public:
+		// for conditions. Branches to label if the value is non zero (onTrue) or zero (!onTrue), otherwise falls through.
+		// By default the value is worked out into a register and tested against $0, comparisons override this to branch on their operands
+		virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const {
+			if(compileConstantBranch(code,onTrue,label)){
+				return;
+			}
+			int condReg = code.newReg();
+			compile(dst,bindings,code,condReg,returnLoc);
+			code.branch(onTrue ? OP_BNE : OP_BEQ,condReg,0,label);
+		}
 
+		// a condition known at compile time is either a jump or nothing at all. Returns false if it is not known
+		bool compileConstantBranch(FunctionCode & code, bool onTrue, int label) const {
+			int value;
+			if(!constantValue(value)){
+				return false;
+			}
+			if((value!=0)==onTrue){
+				code.jump(label);
+			}
+			return true;
+		}
 };
 
 
 
 class AssignmentExpression : public Expression{ // ie for EXPRESSION = EXPRESSION	
 	protected:
-		std::string target; // has a left expressions
+		Symbol target; // has a left expressions
 		ExpressionPtr value; // to be assigned to right expression
 		
 	public:
-		AssignmentExpression(std::string _target, ExpressionPtr _value) : target(_target), value(_value){}
+		AssignmentExpression(Symbol _target, ExpressionPtr _value) : target(_target), value(_value){}
 		
 		const Expression *getvalue() const;
 		
 		virtual void print(std::ostream &dst) const override {
-			dst<<target;
+			dst<<target.name();
 			dst << " = ";
 			value->print(dst);
 		}
 		
 		virtual void translate(std::ostream &dst, int indent) const override { // for python translation requirement
-			dst<<target;
+			dst<<target.name();
 			dst << " = ( ";
 			value->translate(dst,indent);
 			dst << " )";
 		}
 		
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {	 
-			
-			
-			if(bindings.isGlob(target)){ // ie when assigning value to a global variable
-			
-				int x =regs.EmptyRegister(); // obtain one empty register
-				regs.ReserveRegister(x); // reserve it. 
-				int y =regs.EmptyRegister(); // and another
-				regs.ReserveRegister(y);
-				
-				// need two registers temporatily - one for storing result, one for storing operand
-				
-				destReg = "$" + std::to_string(x);
-				std::string globReg = "$" + std::to_string(y);
-				
-				std::cerr<<"storing a global"<<std::endl;
-				
-				// some boiler plate to allow global assignment to work
-				dst<<"lui "<<globReg<<",\%hi("<<target<<")"<<std::endl;
-				dst<<"addiu "<<globReg<<", \%lo("<<target<<")"<<std::endl;
-				
-				/* recursively call compile on the value expression.
-					consider the following; x = a + b;
-					to assign correctly, must work out value of a+b
-				*/
-				value->compile(dst,bindings,regs,destReg,returnLoc);			
-				
-				dst<<"sw	"<<destReg<<", ("<<globReg<<")"<<std::endl;
-				
-				// now mark registers as unused
-				regs.ReleaseRegister(x);
-				regs.ReleaseRegister(y);
+		virtual int registerNeed() const override { return value->registerNeed(); }
+
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			/* recursively call compile on the value expression.
+				consider the following; x = a + b;
+				to assign correctly, must work out value of a+b. It goes into a temporary first, as a+b may read x
+			*/
+			int tmp = code.newReg();
+			value->compile(dst,bindings,code,tmp,returnLoc);
+
+			if(bindings.isGlob(target.id)){ // ie when assigning value to a global variable
+				TRACE(TRACE_CODEGEN, TRACE_DEBUG, "storing a global");
+				code.storeGlobal(tmp,target.name());
 			}
-			
-			else{ // the case for assigning to a local variable. Largely the same as above
-				int tmp = regs.EmptyRegister();
-				regs.ReserveRegister(tmp);
-				destReg = "$" + std::to_string(tmp);
-				value->compile(dst, bindings, regs, destReg,returnLoc);
-				dst<<"sw "<<destReg<<","<<bindings.getOffset(target)<<"($fp)"<<std::endl;
-			
-				std::cerr<<"By the way, I think that varb "<<target<<" lives at "<<bindings.getOffset(target)<<"and it was stored like a local"<<std::endl; // legacy debug
-				regs.ReleaseRegister(tmp);
+			else if(bindings.isBound(target.id)){ // the case for assigning to a local variable
+				TRACE(TRACE_CODEGEN, TRACE_DEBUG, "By the way, I think that varb "<<target.name()<<" lives in $v"<<bindings.getReg(target.id)-FIRST_VREG<<" and it was stored like a local");
+				code.move(bindings.getReg(target.id),tmp);
 			}
-			destReg = "NULL";
-			
-			
+			else{
+				TRACE(TRACE_CODEGEN, TRACE_INFO, "varb "<<target.name()<<" is not in scope, assignment dropped");
+			}
+			code.move(destReg,tmp); // the value of an assignment is the value assigned
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
 			//target name irrelevant, will be assigned under a name and offset value
@@ -99,7 +95,7 @@ class FunctionCall : public Expression{
 		FunctionCall(std::string _id, NodePtr _vlist) : id(_id), vlist(_vlist) {}
 		
 		virtual void print(std::ostream &dst) const override {
-			std::cerr<<"Not implemented"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_NOISE, "Not implemented");
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
 			dst<<id<<" ( ";
@@ -108,43 +104,22 @@ class FunctionCall : public Expression{
 			}
 			dst<<" )";
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
 			// currently only works on functions that do not take inputs
-			
-			//store the necassary registers. I need to save 19. 19*4=76
-			dst<<"addiu $fp, $fp, -88"<<std::endl; // 88 on 76 as additional space needed by convention
-			int offset =8;
-			for(int i = 8;i<=25;i++){
-				dst<<"sw $"<<i<<", "<<offset<<"($fp)"<<std::endl;
-				offset=offset+4;
+			if(vlist!=NULL){
+				TRACE(TRACE_CODEGEN, TRACE_INFO, "arguments to "<<id<<" are not passed");
 			}
-			dst<<"sw $31, 4($fp)"<<std::endl;
-			//call function
-			
-			dst<<"jal "<<id<<std::endl;
-			dst<<"nop"<<std::endl;
-			
-			
-			//recover stuff
-			
-			dst<<"lw $31, 4($fp)"<<std::endl;
-			offset =8;
-			for(int i = 8;i<=25;i++){
-				
-				dst<<"lw $"<<i<<", "<<offset<<"($fp)"<<std::endl;
-				offset=offset+4;
-			}
-			
-			//put function output (reg2) into destReg
-			
-			dst<<"move "<<destReg<<",$2"<<std::endl;
-			//restore fp
-			dst<<"addiu $fp, $fp, 88"<<std::endl;
+			// the register allocator saves whichever temporaries it used around the call
+			code.call(id);
+			code.move(destReg,2); //put function output (reg2) into destReg
 		}
+		// a call clobbers every temporary, so whatever else an expression has worked out must be saved around it.
+		// Calling first, before there is anything to save, is cheaper
+		virtual int registerNeed() const override { return 16; }
 		virtual void explore(int & declarations, Context & bindings) const override{
 			
 			vlist->explore(declarations,bindings);
-			std::cerr<<"An function call can't contain a declaration, stopping"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_NOISE, "An function call can't contain a declaration, stopping");
 		}
 };
 
@@ -157,7 +132,7 @@ class VarList : public Node{ // a list of variables, as part of a function call
 		VarList(std::string _current) : current(_current), next(NULL){}
 		VarList(std::string _current, NodePtr _next) : current(_current), next(_next){}
 		virtual void print(std::ostream &dst) const override {
-			std::cerr<<"Not implemented"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_NOISE, "Not implemented");
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
 			if(next!=NULL){				
@@ -166,14 +141,14 @@ class VarList : public Node{ // a list of variables, as part of a function call
 			}
 			dst<<current;
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			std::cerr<<"Varlist compilation not implemented"<<std::endl;
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			TRACE(TRACE_CODEGEN, TRACE_INFO, "Varlist compilation not implemented");
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
 			if(next!=NULL){
 				next->explore(declarations,bindings);
 			}
-			else{std::cerr<<"Have reached the end of a VarList, stopping"<<std::endl;}
+			else{TRACE(TRACE_EXPLORE, TRACE_NOISE, "Have reached the end of a VarList, stopping");}
 		}
 };
 
@@ -181,13 +156,94 @@ class Operator : public Expression {
 protected:
 	NodePtr left;
 	NodePtr right;
+	int need; // registerNeed, worked out once here as the children are always made first
 	
 public:
-	Operator(NodePtr _left, NodePtr _right) : left(_left), right(_right){}
+	Operator(NodePtr _left, NodePtr _right) : left(_left), right(_right){
+		int l = left->registerNeed();
+		int r = right->registerNeed();
+		if(left==right){ // unary, the operand is in both
+			need = l;
+		}
+		else{
+			need = l==r ? l+1 : std::max(l,r); // with equal needs one value has to wait in a register while the other is worked out
+		}
+	}
+	virtual int registerNeed() const override { return need; }
 	virtual const char *getOpcode() const = 0;
 	NodePtr getLeft() const { return left; }
 	NodePtr getRight() const { return right; }
+
+	// works out l op r as the generated code would, wrapping at 32 bits. Returns false where C leaves the
+	// result undefined (dividing by 0, shifting by 32 or more), so those are still done at run time.
+	// Unary operators have the operand in both left and right, and use r
+	virtual bool fold(int l, int r, int &result) const { return false; }
+
+	virtual bool constantValue(int &value) const override {
+		int l, r;
+		return right->constantValue(r) && left->constantValue(l) && fold(l,r,value);
+	}
+
+	// compiles left into leftReg and right into rightReg, doing the side that needs more registers first.
+	// C does not fix which operand is evaluated first, so this is free to choose
+	void compileOperands(AsmWriter &dst, Context & bindings, FunctionCode & code, int leftReg, int rightReg, int returnLoc) const {
+		if(right->registerNeed()>left->registerNeed()){
+			right->compile(dst,bindings,code,rightReg,returnLoc);
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+		}
+		else{
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			right->compile(dst,bindings,code,rightReg,returnLoc);
+		}
+	}
+
+	// compileBranch for one operand, which the parser only hands us as a Node
+	void branchOn(NodePtr side, AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const {
+		ExpressionPtr e = dynamic_cast<ExpressionPtr>(side);
+		if(e!=NULL){
+			e->compileBranch(dst,bindings,code,onTrue,label,returnLoc);
+			return;
+		}
+		int reg = code.newReg();
+		side->compile(dst,bindings,code,reg,returnLoc);
+		code.branch(onTrue ? OP_BNE : OP_BEQ,reg,0,label);
+	}
+
+	// instruction selection for a constant operand. If the right side (or either, if op commutes) is a constant that fits
+	// immOp's immediate, the other side goes into destReg and is op'd with the constant directly, without a li.
+	// Returns false otherwise, for the register form
+	bool compileImmediate(AsmWriter &dst, Context & bindings, FunctionCode & code, Opcode immOp, bool commutes, int destReg, int returnLoc) const {
+		int c;
+		NodePtr other = left;
+		if(!right->constantValue(c) || !fitsImmediate(immOp,c)){
+			if(!commutes || !left->constantValue(c) || !fitsImmediate(immOp,c)){
+				return false;
+			}
+			other = right;
+		}
+		other->compile(dst,bindings,code,destReg,returnLoc);
+		code.opImm(immOp,destReg,destReg,c);
+		return true;
+	}
+
+	// called first thing in compile, a constant expression is a single li
+	bool compileConstant(FunctionCode & code, int destReg) const {
+		int value;
+		if(!constantValue(value)){
+			return false;
+		}
+		code.li(destReg,value);
+		return true;
+	}
 };
+
+// k if c is 2 to the k, otherwise -1
+inline int exactLog2(int c){
+	if(c<=0 || (c&(c-1))!=0){
+		return -1;
+	}
+	return __builtin_ctz(c);
+}
 // all implementation of operators moved to ast_operators.hpp
 
 #endif
@@ -8,14 +8,10 @@
 #include <map>
 #include <memory>
 #include <vector>
+#include "../symbols.hpp"
+#include "../mips.hpp"
 
-
- // a global variab (gasp) to track global variables as they are parsed
-static int myGlobVarbCounter = 0;
-
-static std::vector<std::string> myGlobVarbContainer; // another global variable, helping with translation from c to python
-
-static int unique_name =0; // a global boolean for making unique names for labels. Increment after use
+// what used to be globals here (the list of globals, the label counter) is per file now, in session.hpp
 
 class Node; //template function, contains only virtual functions to overwrite.
 class Expression;
@@ -52,14 +48,21 @@ public:
     { throw std::runtime_error("Not implemented."); }
 
 	virtual void translate(std::ostream &dst, int indent) const =0;
+
+	// constant folding. If the value is known at compile time it goes in value and this returns true
+	virtual bool constantValue(int &value) const { return false; }
+
+	// Sethi-Ullman number, how many registers working this out needs at once. Operators do the side
+	// that needs more first, so the other side's value is not held in a register all the while
+	virtual int registerNeed() const { return 1; }
 	
 	
-	//return loc is a string of where to jump to if return called.
-	//dst is the output stream
+	//return loc is the label (in code) to jump to if return called.
+	//dst is the output stream, only written by top level nodes. Function bodies go into code first
 	//bindings starts empty, contains the bindings that you are aware of
-	//regs is the register status
-	//destReg starts "NULL" - its where to put the output
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const =0; // will also need to take arguments by reference of type registers and context, its just the context will be empty until it finds an existing context.
+	//code is the function being built, in virtual registers (see mips.hpp)
+	//destReg starts NO_REG - its the register to put the output in
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const =0;
 
 	virtual void explore(int & declarations, Context & bindings)const=0; // will also need to take argument by reference of type context, so that context can propegate through
 
@@ -3,7 +3,8 @@
 #ifndef ast_operators_hpp
 #define ast_operators_hpp
 
-extern int unique_name;
+#include <climits>
+
 
 //Start of Arithmetic Operators
 
@@ -31,19 +32,33 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-	
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"addu "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = (int)((unsigned)l+(unsigned)r); // unsigned, so overflow wraps instead of being undefined
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c==0){ // x+0
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			return;
+		}
+		if(left->constantValue(c) && c==0){ // 0+x
+			right->compile(dst,bindings,code,destReg,returnLoc);
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_ADDIU,true,destReg,returnLoc)){
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_ADDU,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
 		//unsure if overwriting something counts, but this will need one
-		std::cerr<<"In add, I can terminate here happily. Could have ages ago tbh"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "In add, I can terminate here happily. Could have ages ago tbh");
 	}
 };
 
@@ -71,17 +86,30 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"sub "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = (int)((unsigned)l-(unsigned)r);
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c==0){ // x-0
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			return;
+		}
+		if(right->constantValue(c) && c!=INT_MIN && fitsImmediate(OP_ADDIU,-c)){ // x-c is x+(-c)
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			code.opImm(OP_ADDIU,destReg,destReg,-c);
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_SUBU,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"In sub, I can terminate here happily. Could have ages ago tbh"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "In sub, I can terminate here happily. Could have ages ago tbh");
 
 	}
 };
@@ -110,23 +138,39 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
+	virtual bool fold(int l, int r, int &result) const override {
+		result = (int)((unsigned)l*(unsigned)r);
+		return true;
+	}
+	// x*1 is x, and x times 2 to the k is a shift left by k. Returns false for any other constant
+	bool compileByConstant(AsmWriter &dst, Context & bindings, FunctionCode & code, NodePtr x, int c, int destReg, int returnLoc) const {
+		int k = exactLog2(c);
+		if(k<0){
+			return false;
+		}
+		x->compile(dst,bindings,code,destReg,returnLoc);
+		if(k>0){
+			code.opImm(OP_SLL,destReg,destReg,k);
+		}
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) ? compileByConstant(dst,bindings,code,left,c,destReg,returnLoc)
+				: left->constantValue(c) && compileByConstant(dst,bindings,code,right,c,destReg,returnLoc)){
+			return;
+		}
 		// we only support 32 bit integers. We can safely discard the upper half registers
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"MULT	"<<destReg<<", "<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
-		dst<<"NOP"<<std::endl; //multiplication takes multiple clock cycles?
-		dst<<"MFLO	"<<destReg<<std::endl; // the lower half of the result ends up in reg lo
-		dst<<"NOP"<<std::endl;
-		dst<<"NOP"<<std::endl; // these two also prevent undefined behaviour
-		
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.hilo(OP_MULT,destReg,rightReg);
+		code.mflo(destReg); // the lower half of the result ends up in reg lo. The scheduler adds any nops the hazards need
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -154,22 +198,39 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
+	virtual bool fold(int l, int r, int &result) const override {
+		if(r==0 || (l==INT_MIN && r==-1)){ // no defined answer, leave it to the hardware
+			return false;
+		}
+		result = l/r; // rounds towards 0, like div
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		int k = right->constantValue(c) ? exactLog2(c) : -1;
+		if(k>=0 && k<=16){ // divide by 2 to the k with a shift. Needs 2^k-1 to fit in andi
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			if(k>0){
+				// sra alone rounds down, division rounds towards 0, so negative numbers get 2^k-1 added first
+				int bias = code.newReg();
+				code.opImm(OP_SRA,bias,destReg,31); // all ones if negative, else 0
+				code.opImm(OP_ANDI,bias,bias,(1<<k)-1);
+				code.op3(OP_ADDU,destReg,destReg,bias);
+				code.opImm(OP_SRA,destReg,destReg,k);
+			}
+			return;
+		}
 		// we only support integers
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"DIV	"<<destReg<<", "<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
-		dst<<"NOP"<<std::endl; //division takes multiple clock cycles?
-		dst<<"MFLO	"<<destReg<<std::endl; // the lower half of the result ends up in reg lo
-		dst<<"NOP"<<std::endl;
-		dst<<"NOP"<<std::endl; // these two also prevent undefined behaviour
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.hilo(OP_DIV,destReg,rightReg);
+		code.mflo(destReg); // the lower half of the result ends up in reg lo. The scheduler adds any nops the hazards need
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -205,29 +266,46 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-		int tmp2 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp2);
-		
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		std::string Reg2 = "$" + std::to_string(tmp2);
-		
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		dst<<"slt	"<<Reg2<<", "<<destReg<<", "<<Reg1<<std::endl;
-		dst<<"slt	"<<Reg1<<", "<<Reg1<<", "<<destReg<<std::endl;
-		
-		dst<<"xor "<<destReg<<", "<<Reg1<<", "<<Reg2<<std::endl;
-		dst<<"xori "<<destReg<<", "<<destReg<<", 1"<<std::endl;
-		regs.ReleaseRegister(tmp2);
-		regs.ReleaseRegister(tmp1);
-
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l==r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && (c==0 || fitsImmediate(OP_XORI,c))){
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			if(c!=0){
+				code.opImm(OP_XORI,destReg,destReg,c); // 0 only if they were equal
+			}
+			code.opImm(OP_SLTIU,destReg,destReg,1);
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_XOR,destReg,destReg,rightReg); // 0 only if they were equal
+		code.opImm(OP_SLTIU,destReg,destReg,1);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c==0){ // compare with $0 itself
+			int leftReg = code.newReg();
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			code.branch(onTrue ? OP_BEQ : OP_BNE,leftReg,0,label);
+			return;
+		}
+		int leftReg = code.newReg();
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,leftReg,rightReg,returnLoc);
+		code.branch(onTrue ? OP_BEQ : OP_BNE,leftReg,rightReg,label); // no need for the 0 or 1
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -260,17 +338,46 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"sub "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l!=r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && (c==0 || fitsImmediate(OP_XORI,c))){
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			if(c!=0){
+				code.opImm(OP_XORI,destReg,destReg,c);
+			}
+			code.op3(OP_SLTU,destReg,0,destReg); // any difference at all is true, as 1
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_SUBU,destReg,destReg,rightReg);
+		code.op3(OP_SLTU,destReg,0,destReg); // any difference at all is true, as 1
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c==0){
+			int leftReg = code.newReg();
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			code.branch(onTrue ? OP_BNE : OP_BEQ,leftReg,0,label);
+			return;
+		}
+		int leftReg = code.newReg();
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,leftReg,rightReg,returnLoc);
+		code.branch(onTrue ? OP_BNE : OP_BEQ,leftReg,rightReg,label);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -303,27 +410,48 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-		int tmp2 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp2);
-		
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		std::string Reg2 = "$" + std::to_string(tmp2);
-		
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		
-		dst<<"sltu	"<<Reg2<<",$0,"<<destReg<<std::endl;
-		dst<<"sltu	"<<Reg1<<",$0,"<<Reg1<<std::endl;
-		
-		dst<<"and "<<destReg<<","<<Reg1<<","<<Reg2<<std::endl;
-		regs.ReleaseRegister(tmp2);
-		regs.ReleaseRegister(tmp1);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l && r;
+		return true;
+	}
+	virtual bool constantValue(int &value) const override {
+		int l;
+		if(left->constantValue(l) && l==0){ // the right side never runs, so it does not matter what it is
+			value = 0;
+			return true;
+		}
+		return Operator::constantValue(value);
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		// the right side only runs if the left was true
+		int x = code.newLabel();
+		int end = code.labelSymbol("$and_end",x);
+		code.li(destReg,0);
+		branchOn(left,dst,bindings,code,false,end,returnLoc);
+		branchOn(right,dst,bindings,code,false,end,returnLoc);
+		code.li(destReg,1);
+		code.label(end);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		if(!onTrue){ // either side false is enough to go
+			branchOn(left,dst,bindings,code,false,label,returnLoc);
+			branchOn(right,dst,bindings,code,false,label,returnLoc);
+			return;
+		}
+		int x = code.newLabel();
+		int skip = code.labelSymbol("$and_skip",x);
+		branchOn(left,dst,bindings,code,false,skip,returnLoc); // false already, fall out
+		branchOn(right,dst,bindings,code,true,label,returnLoc);
+		code.label(skip);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -356,27 +484,48 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-		int tmp2 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp2);
-		
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		std::string Reg2 = "$" + std::to_string(tmp2);
-		
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		
-		dst<<"sltu	"<<Reg2<<",$0,"<<destReg<<std::endl;
-		dst<<"sltu	"<<Reg1<<",$0,"<<Reg1<<std::endl;
-		
-		dst<<"or "<<destReg<<","<<Reg1<<","<<Reg2<<std::endl;
-		regs.ReleaseRegister(tmp2);
-		regs.ReleaseRegister(tmp1);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l || r;
+		return true;
+	}
+	virtual bool constantValue(int &value) const override {
+		int l;
+		if(left->constantValue(l) && l!=0){ // the right side never runs
+			value = 1;
+			return true;
+		}
+		return Operator::constantValue(value);
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		// the right side only runs if the left was false
+		int x = code.newLabel();
+		int end = code.labelSymbol("$or_end",x);
+		code.li(destReg,1);
+		branchOn(left,dst,bindings,code,true,end,returnLoc);
+		branchOn(right,dst,bindings,code,true,end,returnLoc);
+		code.li(destReg,0);
+		code.label(end);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		if(onTrue){ // either side true is enough to go
+			branchOn(left,dst,bindings,code,true,label,returnLoc);
+			branchOn(right,dst,bindings,code,true,label,returnLoc);
+			return;
+		}
+		int x = code.newLabel();
+		int skip = code.labelSymbol("$or_skip",x);
+		branchOn(left,dst,bindings,code,true,skip,returnLoc); // true already, fall out
+		branchOn(right,dst,bindings,code,false,label,returnLoc);
+		code.label(skip);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -410,14 +559,25 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		right->compile(dst,bindings,regs,destReg,returnLoc);
-		dst<<"slt "<<destReg<<", "<<"$0, "<<destReg<<std::endl;
-		dst<<"xori "<<destReg<<", "<<destReg<<", 1"<<std::endl;
-		
+	virtual bool fold(int l, int r, int &result) const override {
+		result = !r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		right->compile(dst,bindings,code,destReg,returnLoc);
+		code.opImm(OP_SLTIU,destReg,destReg,1); // 1 only if it was 0
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		branchOn(right,dst,bindings,code,!onTrue,label,returnLoc); // just branch the other way
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -450,23 +610,38 @@ public:
 		right->translate(dst,indent);
 		dst << " )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-
-		
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		dst<<"slt	"<<Reg1<<", "<<Reg1<<", "<<destReg<<std::endl;
-		
-		dst<<"move "<<destReg<<", "<<Reg1<<std::endl;
-
-		regs.ReleaseRegister(tmp1);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l>r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int reg1 = code.newReg();
+		compileOperands(dst,bindings,code,destReg,reg1,returnLoc);
+		code.op3(OP_SLT,destReg,reg1,destReg);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c!=INT_MAX && fitsImmediate(OP_SLTI,c+1)){ // l > c is !(l < c+1)
+			int leftReg = code.newReg();
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			code.opImm(OP_SLTI,leftReg,leftReg,c+1);
+			code.branch(onTrue ? OP_BEQ : OP_BNE,leftReg,0,label);
+			return;
+		}
+		int leftReg = code.newReg();
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,leftReg,rightReg,returnLoc);
+		code.op3(OP_SLT,leftReg,rightReg,leftReg);
+		code.branch(onTrue ? OP_BNE : OP_BEQ,leftReg,0,label);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -499,21 +674,41 @@ public:
 		right->translate(dst,indent);
 		dst << " )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-		
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		dst<<"slt	"<<Reg1<<", "<<destReg<<", "<<Reg1<<std::endl;
-		
-		dst<<"move "<<destReg<<", "<<Reg1<<std::endl;
-		regs.ReleaseRegister(tmp1);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l<r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_SLTI,false,destReg,returnLoc)){
+			return;
+		}
+		int reg1 = code.newReg();
+		compileOperands(dst,bindings,code,destReg,reg1,returnLoc);
+		code.op3(OP_SLT,destReg,destReg,reg1);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && fitsImmediate(OP_SLTI,c)){
+			int leftReg = code.newReg();
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			code.opImm(OP_SLTI,leftReg,leftReg,c);
+			code.branch(onTrue ? OP_BNE : OP_BEQ,leftReg,0,label);
+			return;
+		}
+		int leftReg = code.newReg();
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,leftReg,rightReg,returnLoc);
+		code.op3(OP_SLT,leftReg,leftReg,rightReg);
+		code.branch(onTrue ? OP_BNE : OP_BEQ,leftReg,0,label);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -546,19 +741,43 @@ public:
 		right->translate(dst,indent);
 		dst << " )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		dst<<"slt	"<<Reg1<<", "<<destReg<<", "<<Reg1<<std::endl;
-		dst<<"xori "<<Reg1<<", "<<Reg1<<", 0x1"<<std::endl;
-		dst<<"andi "<<destReg<<", "<<Reg1<<", 0xff"<<std::endl;
-		regs.ReleaseRegister(tmp1);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l>=r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_SLTI,false,destReg,returnLoc)){ // l >= c is !(l < c)
+			code.opImm(OP_XORI,destReg,destReg,1);
+			return;
+		}
+		int reg1 = code.newReg();
+		compileOperands(dst,bindings,code,destReg,reg1,returnLoc);
+		code.op3(OP_SLT,destReg,destReg,reg1);
+		code.opImm(OP_XORI,destReg,destReg,1);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && fitsImmediate(OP_SLTI,c)){ // l >= c is !(l < c)
+			int leftReg = code.newReg();
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			code.opImm(OP_SLTI,leftReg,leftReg,c);
+			code.branch(onTrue ? OP_BEQ : OP_BNE,leftReg,0,label);
+			return;
+		}
+		int leftReg = code.newReg();
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,leftReg,rightReg,returnLoc);
+		code.op3(OP_SLT,leftReg,leftReg,rightReg); // l >= r is !(l < r), so branch the other way instead of xori
+		code.branch(onTrue ? OP_BEQ : OP_BNE,leftReg,0,label);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -591,19 +810,45 @@ public:
 		right->translate(dst,indent);
 		dst << " )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		int tmp1 = regs.EmptyRegister();
-		regs.ReserveRegister(tmp1);
-		std::string Reg1 = "$" + std::to_string(tmp1);
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		right->compile(dst,bindings,regs,Reg1,returnLoc);
-		dst<<"slt	"<<Reg1<<", "<<Reg1<<", "<<destReg<<std::endl;
-		dst<<"xori "<<Reg1<<", "<<Reg1<<", 0x1"<<std::endl;
-		dst<<"andi "<<destReg<<", "<<Reg1<<", 0xff"<<std::endl;
-		regs.ReleaseRegister(tmp1);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l<=r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c!=INT_MAX && fitsImmediate(OP_SLTI,c+1)){ // l <= c is l < c+1
+			left->compile(dst,bindings,code,destReg,returnLoc);
+			code.opImm(OP_SLTI,destReg,destReg,c+1);
+			return;
+		}
+		int reg1 = code.newReg();
+		compileOperands(dst,bindings,code,destReg,reg1,returnLoc);
+		code.op3(OP_SLT,destReg,reg1,destReg);
+		code.opImm(OP_XORI,destReg,destReg,1);
+	}
+	virtual void compileBranch(AsmWriter &dst, Context & bindings, FunctionCode & code, bool onTrue, int label, int returnLoc) const override {
+		if(compileConstantBranch(code,onTrue,label)){
+			return;
+		}
+		int c;
+		if(right->constantValue(c) && c!=INT_MAX && fitsImmediate(OP_SLTI,c+1)){ // l <= c is l < c+1
+			int leftReg = code.newReg();
+			left->compile(dst,bindings,code,leftReg,returnLoc);
+			code.opImm(OP_SLTI,leftReg,leftReg,c+1);
+			code.branch(onTrue ? OP_BNE : OP_BEQ,leftReg,0,label);
+			return;
+		}
+		int leftReg = code.newReg();
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,leftReg,rightReg,returnLoc);
+		code.op3(OP_SLT,leftReg,rightReg,leftReg); // l <= r is !(r < l)
+		code.branch(onTrue ? OP_BEQ : OP_BNE,leftReg,0,label);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 //End of Logical Operators
@@ -633,17 +878,23 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"and "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l&r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_ANDI,true,destReg,returnLoc)){
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_AND,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -671,17 +922,23 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"or "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l|r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_ORI,true,destReg,returnLoc)){
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_OR,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -707,12 +964,19 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		right->compile(dst,bindings,regs,destReg,returnLoc);
-		dst<<"nor "<<destReg<<","<<destReg<<","<<destReg<<std::endl;
+	virtual bool fold(int l, int r, int &result) const override {
+		result = ~r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		right->compile(dst,bindings,code,destReg,returnLoc);
+		code.op3(OP_NOR,destReg,destReg,0);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -740,17 +1004,23 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}	
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"xor "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		result = l^r;
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_XORI,true,destReg,returnLoc)){
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_XOR,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -778,17 +1048,26 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"sll "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		if(r<0 || r>31){
+			return false;
+		}
+		result = (int)((unsigned)l<<r);
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_SLL,false,destReg,returnLoc)){
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_SLLV,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 
@@ -815,17 +1094,26 @@ public:
 		right->translate(dst,indent);
 		dst<<" )";
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		left->compile(dst,bindings,regs,destReg,returnLoc);
-		int tmp = regs.EmptyRegister();
-		regs.ReserveRegister(tmp);
-		std::string rightReg = "$" + std::to_string(tmp);
-		right->compile(dst,bindings,regs,rightReg, returnLoc);
-		dst<<"sra "<<destReg<<","<<destReg<<","<<rightReg<<std::endl;
-		regs.ReleaseRegister(tmp);
+	virtual bool fold(int l, int r, int &result) const override {
+		if(r<0 || r>31){
+			return false;
+		}
+		result = l<0 ? ~(~l>>r) : l>>r; // arithmetic, like srav
+		return true;
+	}
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+		if(compileConstant(code,destReg)){
+			return;
+		}
+		if(compileImmediate(dst,bindings,code,OP_SRA,false,destReg,returnLoc)){
+			return;
+		}
+		int rightReg = code.newReg();
+		compileOperands(dst,bindings,code,destReg,rightReg,returnLoc);
+		code.op3(OP_SRAV,destReg,destReg,rightReg);
 	}
 	virtual void explore(int & declarations, Context & bindings) const override{
-		std::cerr<<"Not implemented"<<std::endl;
+		TRACE(TRACE_EXPLORE, TRACE_NOISE, "Not implemented");
 	}
 };
 #endif
@@ -1,48 +1,41 @@
 #ifndef ast_primitives_hpp
 #define ast_primitives_hpp
 
-extern int unique_name;
 
 class Identifier : public Expression {	//If we can figure out how Variable works then we can tie it in with EqualsOperator so that we know what to return for it
 	protected:
-		std::string id;
-		//int offset;
+		Symbol id; // interned, id.id is the index into the Context table
 	public:
-   	 	Identifier(const std::string &_id) : id(_id) /*, offset(NULL) */ {}
-	    	const std::string getId() const { return id; }
+   	 	Identifier(Symbol _id) : id(_id) {}
+	    	const std::string &getId() const { return id.name(); }
 			virtual void print(std::ostream &dst) const override {
-			dst<<id;
+			dst<<id.name();
 	    	}
 	    	/*virtual double evaluate(const std::map<std::string,double> &bindings) const override{
 	       		return bindings.at(id);
 	    	}    */
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____primID1_____"<<std::endl;
-			dst<<id;
-			std::cerr<<"_____primID2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____primID1_____");
+			dst<<id.name();
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____primID2_____");
 		}
 
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			//std::cerr<<"Here is error"<<std::endl;
-			
-			std::cerr<<"By the way, I think that varb "<<id<<" lives at "<<bindings.getOffset(id)<<std::endl;
-			if(bindings.isGlob(id)){
-				std::cerr<<"I think that the varb was actually a global"<<std::endl;
-				/*
-				dst<<"lui "<<destReg<<", \%hi("<<id<<")"<<std::endl;
-				dst<<"addiu "<<destReg<<". \%lo("<<id<<")"<<std::endl;
-				*/
-				
-				dst<<"lui "<<destReg<<", \%hi("<<id<<")"<<std::endl;
-				dst<<"lw "<<destReg<<", \%lo("<<id<<")("<<destReg<<")"<<std::endl;
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			if(bindings.isGlob(id.id)){
+				TRACE(TRACE_CODEGEN, TRACE_DEBUG, "I think that the varb "<<id.name()<<" was actually a global");
+				code.loadGlobal(destReg,id.name());
+			}
+			else if(bindings.isBound(id.id)){
+				TRACE(TRACE_CODEGEN, TRACE_DEBUG, "I think that the varb "<<id.name()<<" was local, it lives in $v"<<bindings.getReg(id.id)-FIRST_VREG);
+				code.move(destReg,bindings.getReg(id.id));
 			}
 			else{
-				std::cerr<<"I think that the varb was local"<<std::endl;
-				dst<<"lw "<<destReg<<", "<<bindings.getOffset(id)<<"($fp)"<<std::endl;
+				TRACE(TRACE_CODEGEN, TRACE_INFO, "varb "<<id.name()<<" is not in scope, reading it as 0");
+				code.li(destReg,0);
 			}
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"End of branch"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_NOISE, "End of branch");
 		}
 };
 
@@ -52,6 +45,10 @@ class IntLiteral : public Expression {
 	public:
 	    	IntLiteral(int _value) : value(_value) {}
 	    	int getValue() const { return value; }
+		virtual bool constantValue(int &_value) const override {
+			_value = value;
+			return true;
+		}
 	    	virtual void print(std::ostream &dst) const override {
 	     	   dst<<value;
 	    	}
@@ -59,19 +56,16 @@ class IntLiteral : public Expression {
 			return value;
 	    	}*/
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____primINT1_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____primINT1_____");
 			dst<<value;
-			std::cerr<<"_____primINT2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____primINT2_____");
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			std::cerr<<"IntLiteral"<<std::endl;
-
-			dst<<"li "<<destReg<<", "<<value<<std::endl;;
-
-			
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			TRACE(TRACE_CODEGEN, TRACE_DEBUG, "IntLiteral");
+			code.li(destReg,value);
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"End of branch"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_NOISE, "End of branch");
 		}
 };
 
@@ -1,8 +1,11 @@
 #ifndef ast_program_hpp
 #define ast_program_hpp
 
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_set>
 
-extern int unique_name;
 
 class Program : public Node{ // class that points to one GLB_VAR or FNC_DEC, then another program
 
@@ -10,31 +13,119 @@ class Program : public Node{ // class that points to one GLB_VAR or FNC_DEC, the
 		NodePtr current; //points to current FunctionDeclaration or GlobalDeclaration
 		NodePtr next; //points to next program
 		
+		// the whole list, in the order compile has always gone through it, split into globals and functions
+		void flatten(std::vector<NodePtr> &globals, std::vector<NodePtr> &functions) const {
+			NodePtr parts[2] = {next,current};
+			for(int i=0; i<2; i++){
+				if(parts[i]==NULL){
+					continue;
+				}
+				const Program *program = dynamic_cast<const Program *>(parts[i]);
+				if(program!=NULL){
+					program->flatten(globals,functions);
+				}
+				else if(dynamic_cast<const FunctionDecl *>(parts[i])!=NULL){
+					functions.push_back(parts[i]);
+				}
+				else{
+					globals.push_back(parts[i]);
+				}
+			}
+		}
+		
 	public:
 		Program(NodePtr _current) : current(_current), next(NULL){} // constructor with no next
 		Program(NodePtr _current, NodePtr _next) : current(_current), next(_next){} //full constructor
 		
 		virtual void print(std::ostream &dst) const override {
-			std::cerr<<"Print on Program list got called"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Print on Program list got called");
 		
-			std::cerr<<"Print on Program list not implemented"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Print on Program list not implemented");
 		}
 		
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____progLIST1_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____progLIST1_____");
 			if(next!=NULL){
 				next->translate(dst,indent);
 			}
-			std::cerr<<"_____progLIST2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____progLIST2_____");
 			current->translate(dst,indent);
-			std::cerr<<"_____progLIST3_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____progLIST3_____");
 		}
 
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			if(next!=NULL){
-				next->compile(dst,bindings,regs,destReg,returnLoc);
-			}		
-			current->compile(dst,bindings,regs,destReg,returnLoc);
+		// only ever called on the top of the tree. Every global is done first, which binds them all in the root
+		// scope and writes the .data. After that the functions depend on nothing but the root scope, so with
+		// more than one thread (Session::threads) they are compiled side by side, each into its own writer, and
+		// copied out in order. Each thread has its own copy of the Context, back to just the root scope after
+		// every function
+		// With --incremental (Session::index) a function whose key is in the index from last time is copied
+		// from there instead of being compiled, and every function goes into the new index
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			std::vector<NodePtr> globals, functions;
+			flatten(globals,functions);
+			{
+				PhaseTimer codegen(bindings.times(),PHASE_CODEGEN);
+				for(size_t g=0; g<globals.size(); g++){
+					globals[g]->compile(dst,bindings,code,destReg,returnLoc);
+				}
+			}
+			Session *session = bindings.file();
+			FunctionIndex *index = session && session->text ? session->index : NULL; // functions are keyed by their source
+			size_t threads = std::min(bindings.threads(),functions.size());
+			if(threads<=1 && index==NULL){
+				for(size_t f=0; f<functions.size(); f++){
+					functions[f]->compile(dst,bindings,code,destReg,returnLoc);
+				}
+				return;
+			}
+
+			std::vector<std::string> keys(functions.size());
+			std::vector<const char *> old(functions.size(),(const char *)NULL); // from the index, if it was there
+			std::vector<size_t> oldSize(functions.size(),0);
+			std::vector<size_t> todo; // the functions that do need compiling
+			if(index!=NULL){
+				std::unordered_set<std::string> names;
+				for(size_t g=0; g<session->globals.size(); g++){
+					names.insert(session->globals[g].name());
+				}
+				for(size_t f=0; f<functions.size(); f++){
+					const SourceSpan &span = static_cast<const FunctionDecl *>(functions[f])->where();
+					keys[f] = FunctionIndex::key(session->text+span.begin,span.end-span.begin,names,code.emitIR);
+					if(!index->find(keys[f],old[f],oldSize[f])){
+						todo.push_back(f);
+					}
+				}
+			}
+			else{
+				for(size_t f=0; f<functions.size(); f++){
+					todo.push_back(f);
+				}
+			}
+
+			std::vector<AsmWriter> text(functions.size());
+			threads = std::max<size_t>(1,std::min(threads,todo.size()));
+			std::vector<Context> copies(threads-1,bindings); // the calling thread uses bindings itself
+			WorkStealingPool pool(threads);
+			pool.run(todo.size(),[&](size_t worker, size_t t){
+				functions[todo[t]]->compile(text[todo[t]],worker ? copies[worker-1] : bindings,code,destReg,returnLoc);
+			});
+			PhaseTimer output(bindings.times(),PHASE_OUTPUT);
+			for(size_t f=0; f<functions.size(); f++){
+				if(old[f]==NULL){
+					old[f] = text[f].data();
+					oldSize[f] = text[f].size();
+					if(index!=NULL){
+						index->compiled++;
+					}
+				}
+				else{
+					index->reused++;
+				}
+				dst.append(old[f],oldSize[f]);
+				if(index!=NULL){
+					index->record(keys[f],old[f],oldSize[f]);
+				}
+			}
 		}
 		virtual void explore(int & declarations, Context & bindings) const override {
 			if(next != NULL){
@@ -7,7 +7,6 @@
 #include <string>
 
 
-extern int unique_name;
 
 class Statement : public Node {
 	//Once we go over how to separate Expression Statement and ReturnStatement it should be good
@@ -25,24 +24,20 @@ class ExpressionStatement : public Statement {
 			dst<<";"<<std::endl;
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____stateEXPR1_____"<<std::endl;
-			std::cerr<<"Adding indent, indent is currently "<<indent<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateEXPR1_____");
+			TRACE(TRACE_TRANSLATE, TRACE_DEBUG, "Adding indent, indent is currently "<<indent);
 			for(int i=0; i<indent;i++){ //Shold make a function / member function, quick hack for now
 				dst<<" ";
 			}
 			expr->translate(dst,indent);
-			std::cerr<<"_____stateEXPR2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateEXPR2_____");
 			dst<<std::endl;
 		}
-		/*virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override{
-			expr->compile(dst,bindings,regs,destReg,returnLoc);
-		}*/
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			
-			expr->compile(dst,bindings,regs,destReg,returnLoc);
-		}		
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			expr->compile(dst,bindings,code,code.newReg(),returnLoc); // the value is computed into a fresh register and not used
+		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"An expression statement can't contain a declaration, stopping"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_NOISE, "An expression statement can't contain a declaration, stopping");
 		}
 };
 
@@ -61,31 +56,25 @@ class ReturnStatement : public Statement { // added 28/02/18. I think this is th
 			dst<<std::endl;
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____stateRETURN1_____"<<std::endl;
-			std::cerr<<"Adding indent, indent is currently "<<indent<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateRETURN1_____");
+			TRACE(TRACE_TRANSLATE, TRACE_DEBUG, "Adding indent, indent is currently "<<indent);
 			for(int i=0; i<indent;i++){//Shold make a function / member function, quick hack for now
 				dst<<" ";
 			}
 			dst<<"return ";
 			ret->translate(dst,indent);
-			std::cerr<<"_____stateRETURN2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateRETURN2_____");
 			dst<<std::endl;
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override{
-			std::cerr<<"Returning in compile"<<std::endl;
-			destReg="$2";
-			regs.ReserveRegister(2);
-			ret->compile(dst, bindings, regs, destReg,returnLoc);
-			dst<<"j "<<returnLoc<<std::endl;
-			dst<<"nop"<<std::endl;
-			std::cerr<<"YO"<<std::endl;
-			regs.ReleaseRegister(2);
-			destReg="NULL";
-			dst<<std::endl;
-			//destReg will be $2 here
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			TRACE(TRACE_CODEGEN, TRACE_DEBUG, "Returning in compile");
+			int tmp = code.newReg();
+			ret->compile(dst,bindings,code,tmp,returnLoc);
+			code.move(2,tmp); // return values go in $2
+			code.jump(returnLoc);
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"A return statement can't contain a declaration, stopping"<<std::endl;
+			TRACE(TRACE_EXPLORE, TRACE_NOISE, "A return statement can't contain a declaration, stopping");
 		}
 };
 
@@ -100,37 +89,37 @@ class StatementList : public Statement
 	public:
 		//constructor with no next list
 		StatementList(StatementPtr _current) :current(_current),next(NULL){ // wip constructor
-			std::cerr<<"In constructor for StatementList with no next Statement List"<<std::endl;		 
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "In constructor for StatementList with no next Statement List");		 
 		}
 		//constructor with next list
 		StatementList(StatementPtr _current, StatementPtr _next) :current(_current),next(_next){
-			std::cerr<<"In constructor for StatementList with next Statement List"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "In constructor for StatementList with next Statement List");
 		}
 	//will have printer, translator, etc
 	//will simply call the function of those beneath
 	
 	virtual void print(std::ostream &dst) const override {
-		std::cerr<<"Print on statement list got called"<<std::endl;
+		TRACE(TRACE_PARSER, TRACE_DEBUG, "Print on statement list got called");
 		if(next!=NULL){
 			next->print(dst);
 		}
 		current->print(dst);
-		std::cerr<<"Print on statement list successfully finished"<<std::endl;
+		TRACE(TRACE_PARSER, TRACE_DEBUG, "Print on statement list successfully finished");
 	}
 	virtual void translate(std::ostream &dst, int indent) const override {
-		std::cerr<<"_____stateLIST1_____"<<std::endl;
+		TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateLIST1_____");
 		if(next!=NULL){
 			next->translate(dst,indent);
 		}
-		std::cerr<<"_____stateLIST2_____"<<std::endl;
+		TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateLIST2_____");
 		current->translate(dst,indent);
-		std::cerr<<"_____stateLIST3_____"<<std::endl;
+		TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____stateLIST3_____");
 	}
-	virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override{
+	virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
 		if(next!=NULL){
-			next->compile(dst,bindings,regs,destReg,returnLoc);
+			next->compile(dst,bindings,code,destReg,returnLoc);
 		}
-		current->compile(dst,bindings,regs,destReg,returnLoc);
+		current->compile(dst,bindings,code,destReg,returnLoc);
 	}
 	
 	virtual void explore(int & declarations, Context & bindings) const override{
@@ -149,12 +138,10 @@ class ScopeStatement : public Statement{
 							*/
 	public:
 		ScopeStatement(NodePtr _body) :body(_body){}
-		virtual void print(std::ostream &dst) const override {std::cerr<<"Not implemented for ScopeStatement"<<std::endl;}
-		virtual void translate(std::ostream &dst, int indent) const override {std::cerr<<"By the spec, Python doesn't need to deal with nested scopes"<<std::endl;}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		
-			body->compile(dst,bindings,regs,destReg,returnLoc); // nothing fancy, just compile the compound statement I point to
-			
+		virtual void print(std::ostream &dst) const override {TRACE(TRACE_PARSER, TRACE_NOISE, "Not implemented for ScopeStatement");}
+		virtual void translate(std::ostream &dst, int indent) const override {TRACE(TRACE_TRANSLATE, TRACE_DEBUG, "By the spec, Python doesn't need to deal with nested scopes");}
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			body->compile(dst,bindings,code,destReg,returnLoc); // nothing fancy, just compile the compound statement I point to
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
 		
@@ -170,7 +157,7 @@ class IfStatement : public Statement {
 		ExpressionPtr condition; // the execute condition
 		NodePtr body; // actually a compound statement, the body of the if
 	public:
-		IfStatement(ExpressionPtr _condition, NodePtr _body) : condition(_condition), body(_body) {std::cerr<<"If statement constructor"<<std::endl;}
+		IfStatement(ExpressionPtr _condition, NodePtr _body) : condition(_condition), body(_body) {TRACE(TRACE_PARSER, TRACE_DEBUG, "If statement constructor");}
 		virtual void print(std::ostream &dst) const override {//if case exists
 				
 			dst << "if ( ";		//this won't work until bindings map is made
@@ -190,28 +177,13 @@ class IfStatement : public Statement {
 			body->translate(dst, indent+4);
 			dst << std::endl;
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			int x = unique_name;
-			unique_name++;
-			std::string if_t = "$if_s"+std::to_string(x); // start of body
-			std::string if_f = "$if_f"+std::to_string(x); // end of body
-			int y = regs.EmptyRegister(); // number of first free register
-			regs.ReserveRegister(y); // mark register as used
-			std::string condReg = "$"+std::to_string(y);
-			condition->compile(dst,bindings,regs,condReg,returnLoc); // compile the condition, get the result into condReg
-			dst<<"bne	$0, "<<condReg<<", "<<if_t<<std::endl; //If cond not zero, branch to body
-			regs.ReleaseRegister(y);
-			dst<<"nop"<<std::endl;
-			dst<<"b	"<<if_f<<std::endl;
-			dst<<"nop"<<std::endl;
-			dst<<std::endl;
-			dst<<if_t<<":"<<std::endl;
-			body->compile(dst,bindings,regs,destReg,returnLoc);
-			dst<<"b	"<<if_f<<std::endl;
-			dst<<"nop"<<std::endl;
-			dst<<std::endl;
-			dst<<if_f<<":"<<std::endl;
-			std::cerr<<"For testing, I left if here"<<std::endl;
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			int x = code.newLabel();
+			int if_f = code.labelSymbol("$if_f",x); // end of body
+			condition->compileBranch(dst,bindings,code,false,if_f,returnLoc); // skip the body if the condition is false, otherwise fall into it
+			body->compile(dst,bindings,code,destReg,returnLoc);
+			code.label(if_f);
+			TRACE(TRACE_CODEGEN, TRACE_NOISE, "For testing, I left if here");
 		}
 	
 		virtual void explore(int & declarations, Context & bindings) const override{
@@ -227,7 +199,7 @@ class IfElseStatement : public Statement{
 		NodePtr body_f;
 	public:
 		IfElseStatement(ExpressionPtr _condition, NodePtr _t, NodePtr _f) :condition(_condition), body_t(_t), body_f(_f){}
-		virtual void print(std::ostream &dst) const override{std::cerr<<"IFELSE not print implemented"<<std::endl;}
+		virtual void print(std::ostream &dst) const override{TRACE(TRACE_PARSER, TRACE_DEBUG, "IFELSE not print implemented");}
 		virtual void translate(std::ostream &dst, int indent) const override {
 			for(int i=0; i<indent;i++){ //Shold make a function / member function, quick hack for now
 				dst<<" ";
@@ -248,32 +220,16 @@ class IfElseStatement : public Statement{
 			body_t->explore(declarations,bindings);
 			body_f->explore(declarations,bindings);
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			
-			int x = unique_name;
-			unique_name++;
-			std::string if_t = "$if_t"+std::to_string(x); // if true
-			std::string if_e = "$else"+std::to_string(x); // else
-			std::string if_f = "$if_fin"+std::to_string(x); // finish	
-			int y = regs.EmptyRegister(); // number of first free register
-			regs.ReserveRegister(y); // mark register as used
-			std::string condReg = "$"+std::to_string(y);
-			condition->compile(dst,bindings,regs,condReg,returnLoc); // compile the condition, get the result into condReg
-			dst<<"bne	$0, "<<condReg<<", "<<if_t<<std::endl; //If cond not zero, branch to body
-			regs.ReleaseRegister(y);
-			dst<<"nop"<<std::endl;
-			dst<<"b	"<<if_e<<std::endl;
-			dst<<"nop"<<std::endl;
-			dst<<if_t<<":"<<std::endl;
-			body_t->compile(dst,bindings,regs,destReg,returnLoc);
-			dst<<"b	"<<if_f<<std::endl;
-			dst<<"nop"<<std::endl;
-			dst<<if_e<<":"<<std::endl;
-			body_f->compile(dst,bindings,regs,destReg,returnLoc);
-			dst<<"b	"<<if_f<<std::endl;
-			dst<<"nop"<<std::endl;
-			dst<<if_f<<":"<<std::endl;
-			
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			int x = code.newLabel();
+			int if_e = code.labelSymbol("$else",x); // else
+			int if_f = code.labelSymbol("$if_fin",x); // finish
+			condition->compileBranch(dst,bindings,code,false,if_e,returnLoc); // true falls through into body_t
+			body_t->compile(dst,bindings,code,destReg,returnLoc);
+			code.jump(if_f);
+			code.label(if_e);
+			body_f->compile(dst,bindings,code,destReg,returnLoc); // falls through to the end
+			code.label(if_f);
 		}
 };
 
@@ -284,7 +240,7 @@ class WhileStatement : public Statement {
 		ExpressionPtr condition;
 		NodePtr body; // actually a statement list, the body of the while
 	public:
-		WhileStatement(ExpressionPtr _condition, NodePtr _body) : condition(_condition), body(_body) {std::cerr<<"While statement constructor"<<std::endl;}
+		WhileStatement(ExpressionPtr _condition, NodePtr _body) : condition(_condition), body(_body) {TRACE(TRACE_PARSER, TRACE_DEBUG, "While statement constructor");}
 		virtual void print(std::ostream &dst) const override {//if case exists
 			dst << "while (";
 			condition->print(dst);
@@ -303,31 +259,20 @@ class WhileStatement : public Statement {
 			body->translate(dst, indent + 4);
 			dst << std::endl;
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-		
-			int x = unique_name;
-			unique_name++;
-			std::string cond = "$cond"+std::to_string(x); // if true
-			std::string loop = "$body"+std::to_string(x); // else
-			std::string end = "$end"+std::to_string(x); // finish	
-			int y = regs.EmptyRegister(); // number of first free register
-			regs.ReserveRegister(y); // mark register as used
-			std::string condReg = "$"+std::to_string(y);
-			dst<<cond<<":"<<std::endl;
-			condition->compile(dst,bindings,regs,condReg,returnLoc); // compile the condition, get the result into condReg
-			dst<<"bne	$0, "<<condReg<<", "<<loop<<std::endl;
-			dst<<"nop"<<std::endl;
-			dst<<"b "<<end<<std::endl;
-			dst<<"nop"<<std::endl;
-		
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			int x = code.newLabel();
+			int cond = code.labelSymbol("$cond",x); // the test
+			int loop = code.labelSymbol("$body",x); // the body
+			// the test goes at the bottom, so each time round the loop is one taken branch. Getting in costs one jump
+			code.jump(cond);
+
 			//body
-			dst<<loop<<":"<<std::endl;
-			body->compile(dst,bindings,regs,destReg,returnLoc);
-			dst<<"b "<<cond<<std::endl;
-			dst<<"nop"<<std::endl;
-		
-			//end
-			dst<<end<<":"<<std::endl;
+			code.label(loop);
+			body->compile(dst,bindings,code,destReg,returnLoc);
+
+			//test, back to the top while it holds, otherwise fall out
+			code.label(cond);
+			condition->compileBranch(dst,bindings,code,true,loop,returnLoc);
 		}
 	
 		virtual void explore(int & declarations, Context & bindings) const override{
@@ -6,13 +6,6 @@
 #include <iostream> 
 #include <vector>
 
-//bloody global variables for handling global variables
-extern int myGlobVarbCounter;
-
-extern std::vector<std::string> myGlobVarbContainer;
-
-extern int unique_name;
-
 class Declaration : public Node{
 	
 };
@@ -21,25 +14,25 @@ class DeclLocal : public Declaration{
 
 	protected: 
 		std::string type;
-		std::string var_id;
+		Symbol var_id;
 		ExpressionPtr value;
 	
 	public:
-		DeclLocal(std::string _type, std::string _var_id) : //constructor with no value assignment
+		DeclLocal(std::string _type, Symbol _var_id) : //constructor with no value assignment
 			type(_type),
 			var_id(_var_id),
 			value(NULL)
-			{std::cerr<<"New Declaration with no value assigned"<<std::endl;}
-		DeclLocal(std::string _type, std::string _var_id, ExpressionPtr _value) : //constructor with variable assignment
+			{TRACE(TRACE_PARSER, TRACE_DEBUG, "New Declaration with no value assigned");}
+		DeclLocal(std::string _type, Symbol _var_id, ExpressionPtr _value) : //constructor with variable assignment
 			type(_type),
 			var_id(_var_id),
 			value(_value)
-			{std::cerr<<"New Declaration with value assigned"<<std::endl;}
+			{TRACE(TRACE_PARSER, TRACE_DEBUG, "New Declaration with value assigned");}
 			
 		virtual void print(std::ostream &dst) const override {
 			dst<<type;
 			dst << " ";
-			dst << var_id;
+			dst << var_id.name();
 			dst<<" ";
 			if(value!=NULL){
 				dst<<"= ";
@@ -50,7 +43,7 @@ class DeclLocal : public Declaration{
 			for(int i=0; i<indent;i++){//Shold make a function / member function, quick hack for now
 				dst<<" ";
 			}	
-			dst<<var_id;
+			dst<<var_id.name();
 			dst<<" = ";
 			if(value!=NULL){
 				value ->translate(dst,indent);
@@ -60,32 +53,17 @@ class DeclLocal : public Declaration{
 			}
 			dst<<std::endl;
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			//need to specify an open register for the new variable
-			//need to use addi or addiu
-			//reserve reg
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			//the variable comes into scope here, and gets a register of its own for as long as it is in scope
+			int reg = code.newVariableReg();
+			bindings.growTable(var_id.id,reg);
+			TRACE(TRACE_CODEGEN, TRACE_DEBUG, "By the way, I think that varb "<<var_id.name()<<" lives in $v"<<reg-FIRST_VREG);
 			if(value != NULL){		//value case
-				int tmp = regs.EmptyRegister();
-				regs.ReserveRegister(tmp);
-				destReg = "$"+std::to_string(tmp);
-				value->compile(dst, bindings, regs, destReg,returnLoc);
-				dst<<std::endl;
-				std::cerr<<bindings.getOffset(var_id)<<std::endl;
-				dst<<"sw "<<destReg<<","<<bindings.getOffset(var_id)<<"($fp)"<<std::endl;
-				
-				std::cerr<<"By the way, I think that varb "<<var_id<<" lives at "<<bindings.getOffset(var_id)<<std::endl;
-				
-				std::cerr<<"Test 1"<<std::endl;
-				destReg = "NULL";
-				regs.ReleaseRegister(tmp);
-			}
-			else{
-
+				value->compile(dst,bindings,code,reg,returnLoc);
 			}
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			declarations++;
-			bindings.growTable(var_id);
+			declarations++; // only the count is needed, registers are handed out during compile
 		}
 };
 
@@ -99,36 +77,36 @@ class DeclList : public Declaration{
 	public:
 		//constructor with no next list
 		DeclList(DeclPtr _current) : current(_current), next(NULL){
-			std::cerr<<"Constructed DeclList with no next Decl"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Constructed DeclList with no next Decl");
 		}
 		//constructor with next list
 		DeclList(DeclPtr _current, DeclPtr _next) : current(_current), next(_next){
-			std::cerr<<"Constructed DeclList with next Decl"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Constructed DeclList with next Decl");
 		}
 		virtual void print(std::ostream &dst) const override {
-			std::cerr<<"Print on decl list got called"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Print on decl list got called");
 			if(next!=NULL){
 				next->print(dst);
 			}
 			current->print(dst);
-			std::cerr<<"Print on declaration list successfully finished"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Print on declaration list successfully finished");
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
-			std::cerr<<"_____declLIST1_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declLIST1_____");
 			if(next!=NULL){
 				next->translate(dst,indent);
 			}
-			std::cerr<<"_____declLIST2_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declLIST2_____");
 			current->translate(dst,indent);
-			std::cerr<<"_____declLIST3_____"<<std::endl;
+			TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declLIST3_____");
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
 			if(next!=NULL){
 
-			next->compile(dst,bindings,regs,destReg,returnLoc);
+			next->compile(dst,bindings,code,destReg,returnLoc);
 
 			}
-			current->compile(dst,bindings,regs,destReg,returnLoc);
+			current->compile(dst,bindings,code,destReg,returnLoc);
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
 			if(next!=NULL){
@@ -141,35 +119,29 @@ class DeclList : public Declaration{
 class DeclGlobal : public Node{ 
 	protected:
 		std::string type;
-		std::string var_id;
+		Symbol var_id;
 		ExpressionPtr value;
 	public:
-		DeclGlobal(std::string _type, std::string _var_id) : 
+		DeclGlobal(std::string _type, Symbol _var_id) : 
 			type(_type),
 			var_id(_var_id),
 			value(NULL) {
 			
-			std::cerr<<"Behold, a global with no initial value. Increment the counter and store the relevant details!"<<std::endl;
-			myGlobVarbCounter=true;
-			myGlobVarbContainer.push_back(type);
-			myGlobVarbContainer.push_back(var_id);
-			std::cerr<<"The global constructor hath finished!"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Behold, a global with no initial value!");
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "The global constructor hath finished!");
 		}
-		DeclGlobal(std::string _type, std::string _var_id, ExpressionPtr _value) :
+		DeclGlobal(std::string _type, Symbol _var_id, ExpressionPtr _value) :
 			type(_type),
 			var_id(_var_id),
 			value(_value) {
 			
-			std::cerr<<"Behold, a global with an initial value. Increment the counter and store the relevant details!"<<std::endl;
-			myGlobVarbCounter=true;
-			myGlobVarbContainer.push_back(type);
-			myGlobVarbContainer.push_back(var_id);
-			std::cerr<<"The global constructor hath finished!"<<std::endl;
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "Behold, a global with an initial value!");
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "The global constructor hath finished!");
 		}
 		virtual void print(std::ostream &dst) const override {
 			dst<<type;
 			dst << " ";
-			dst << var_id;
+			dst << var_id.name();
 			dst<<" ";
 			if(value!=NULL){
 				dst<<"= ";
@@ -180,7 +152,7 @@ class DeclGlobal : public Node{
 			for(int i=0; i<indent;i++){//Shold make a function / member function, quick hack for now
 				dst<<" ";
 			}	
-			dst<<var_id;
+			dst<<var_id.name();
 			dst<<" = ";
 			if(value!=NULL){
 				value ->translate(dst,indent);
@@ -190,22 +162,25 @@ class DeclGlobal : public Node{
 			}
 			dst<<std::endl;
 		}
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
 			
-			dst<<".globl "<<var_id<<std::endl;
-			dst<<".data "<<std::endl;
-			dst<<".align 2"<<std::endl;
-			if(value!=NULL){
-				dst<<var_id<<":"<<std::endl;
-				dst<<".word ";
-				value->translate(dst,0);
-				dst<<std::endl;
-				dst<<".text"<<std::endl;
-				dst<<".align 2"<<std::endl;
+			// Program compiles in source order and we are outside every function here, so this binding is
+			// made in the root scope and is seen by every function after it without being copied
+			bindings.growGlobals(var_id.id);
+			TRACE(TRACE_CODEGEN, TRACE_DEBUG, "Found a global called "<<var_id.name());
+			int initial = 0; // C starts globals without an initialiser at 0
+			if(value!=NULL && !value->constantValue(initial)){ // a call, another variable, or something like 1/0
+				bindings.file()->error("the initialiser of global "+var_id.name()+" is not a constant expression");
 			}
+			dst<<".globl "<<var_id.name()<<'\n';
+			dst<<".data "<<'\n';
+			dst<<".align 2"<<'\n';
+			dst<<var_id.name()<<":"<<'\n';
+			dst<<".word "<<initial<<'\n'; // already folded, so the assembler never sees an expression
+			dst<<".text"<<'\n';
+			dst<<".align 2"<<'\n';
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			std::cerr<<"Do I make it here?"<<std::endl;
 			declarations++;
 			
 		}
@@ -215,33 +190,22 @@ class CompoundStatement : public Node{
 	protected:
 		StatementPtr sref;
 		DeclPtr dref;
-		Context* varb_bindings; // as it currently stands, Compound Statements are our only change of scope. So each compount statement must have a Context.
 		int	noDecls; // count how many declarations exist below you
 		
 	public:
-		CompoundStatement(StatementPtr _sref) : sref(_sref), noDecls(0)
+		CompoundStatement(StatementPtr _sref) : sref(_sref), dref(NULL), noDecls(0)
 		{
-			varb_bindings = new Context;
-			std::cerr<<"In constructor for CompoundStatement with no decl list"<<std::endl;
-			//sref->explore(noDecls,*varb_bindings);
-
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "In constructor for CompoundStatement with no decl list");
 		}	
 			
-		CompoundStatement(DeclPtr _dref) : dref(_dref), noDecls(0)
+		CompoundStatement(DeclPtr _dref) : sref(NULL), dref(_dref), noDecls(0)
 		{
-			varb_bindings = new Context;
-			std::cerr<<"In constructor for CompoundStatement with no statement list"<<std::endl;
-			//dref->explore(noDecls,*varb_bindings);
-
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "In constructor for CompoundStatement with no statement list");
 		}
 		
 		CompoundStatement(StatementPtr _sref,DeclPtr _dref) : sref(_sref),dref(_dref), noDecls(0)
 		{
-			varb_bindings = new Context;
-			std::cerr<<"In constructor for CompoundStatement with both lists"<<std::endl;
-			//dref->explore(noDecls,*varb_bindings);
-			//sref->explore(noDecls,*varb_bindings);
-			
+			TRACE(TRACE_PARSER, TRACE_DEBUG, "In constructor for CompoundStatement with both lists");
 		}	
 			
 		virtual void print(std::ostream &dst) const override {
@@ -253,56 +217,38 @@ class CompoundStatement : public Node{
 			}
 		}
 		virtual void translate(std::ostream &dst, int indent) const override {
-			if(myGlobVarbCounter!=0){
-				std::cerr<<"There were some global variables to translate"<<std::endl;
-				
-				for (int i=1; i<myGlobVarbContainer.size();i=i+2){
-					for(int i=0; i<indent;i++){//Shold make a function / member function, quick hack for now
-						dst<<" ";
-					}
-					dst<<"global "<<myGlobVarbContainer[i]<<std::endl;
-				}
-				
-			}
 			if(dref!=NULL){
-				std::cerr<<"_____declCOMP1_____"<<std::endl;
+				TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declCOMP1_____");
 				dref->translate(dst,indent);
-				std::cerr<<"_____declCOMP2_____"<<std::endl;
+				TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declCOMP2_____");
 			}
 			if(sref!=NULL){
-				std::cerr<<"_____declCOMP1_____"<<std::endl;
+				TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declCOMP1_____");
 				sref->translate(dst,indent);
-				std::cerr<<"_____declCOMP2_____"<<std::endl;
+				TRACE(TRACE_TRANSLATE, TRACE_NOISE, "_____declCOMP2_____");
 			}
 		}
-		//each compile construction will require a context for itself
-		virtual void compile(std::ostream &dst, Context & bindings, Registers & regs, std::string destReg, std::string returnLoc) const override {
-			
-			if(bindings.yesGlobals() > 0){
-				varb_bindings->insertGlobals(bindings);
-				std::cerr<<"I recognized some globals and added them"<<std::endl;
-			}
-			
-			std::cerr<<"Testing, dump bindings"<<std::endl;
-			varb_bindings->dumpTable();
-			//bindings = *varb_bindings;
+		//compound statements are our only change of scope. Declarations inside are bound on the way in and dropped on the way out
+		virtual void compile(AsmWriter &dst, Context & bindings, FunctionCode & code, int destReg, int returnLoc) const override {
+			bindings.enterScope();
 			if(dref!=NULL){
-				dref->compile(dst,*varb_bindings,regs,destReg,returnLoc);
+				dref->compile(dst,bindings,code,destReg,returnLoc);
+			}
+			if(TRACE_ON(TRACE_CODEGEN, TRACE_NOISE)){
+				bindings.dumpTable();
 			}
 			if(sref!=NULL){
-				sref->compile(dst,*varb_bindings,regs,destReg,returnLoc);
+				sref->compile(dst,bindings,code,destReg,returnLoc);
 			}
+			bindings.leaveScope();
 		}
 		virtual void explore(int & declarations, Context & bindings) const override{
-			// here be interesting things
-			varb_bindings->changeOffset(bindings.returnOffset());
-			varb_bindings->mergeMaps(bindings);
 			if(dref!=NULL){
-				dref->explore(declarations,*varb_bindings);
+				dref->explore(declarations,bindings);
 			}
 
 			if(sref!=NULL){
-				sref->explore(declarations,*varb_bindings);
+				sref->explore(declarations,bindings);
 			}
 
 		}
@@ -0,0 +1,140 @@
+#ifndef arena_hpp
+#define arena_hpp
+
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <iostream>
+
+/* A bump pointer allocator. Everything the parser builds for one translation unit (every Node
+	and every token string from the lexer) is placed in here, one after another in big blocks,
+	so it all sits close together in memory and is freed in one go instead of being leaked.
+
+	Objects with destructors (most nodes hold std::strings) are remembered and destroyed, newest
+	first, when the arena is reset or destroyed. Nothing is ever freed individually.
+*/
+
+class Arena{
+	protected:
+		struct Block{
+			char *data;
+			size_t size;
+		};
+		struct Finaliser{ // how to destroy one object that needs it
+			void (*destroy)(void *);
+			void *object;
+		};
+
+		std::vector<Block> blocks; // blocks[current] is being filled, anything after it is spare
+		std::vector<Finaliser> finalisers;
+		size_t current;
+		size_t used; // bytes used in blocks[current]
+		size_t blockSize;
+
+		//statistics, for --mem-report
+		unsigned long allocations; // number of objects handed out since the last reset
+		unsigned long bytes; // bytes handed out since the last reset, including alignment padding
+
+		template<class T>
+		static void destroy(void *object){
+			static_cast<T *>(object)->~T();
+		}
+
+		void newBlock(size_t atLeast){
+			// reuse a spare block from before a reset if it is big enough, otherwise get a new one
+			current = blocks.empty() ? 0 : current+1;
+			if(current<blocks.size() && blocks[current].size>=atLeast){
+				used = 0;
+				return;
+			}
+			size_t size = atLeast>blockSize ? atLeast : blockSize;
+			Block b;
+			b.data = static_cast<char *>(std::malloc(size));
+			if(b.data==NULL){
+				throw std::bad_alloc();
+			}
+			b.size = size;
+			blocks.insert(blocks.begin()+current,b);
+			used = 0;
+		}
+
+	public:
+		Arena(size_t _blockSize = 256*1024) :
+			current(0),
+			used(0),
+			blockSize(_blockSize),
+			allocations(0),
+			bytes(0)
+		{}
+
+		~Arena(){
+			reset();
+			for(size_t i=0; i<blocks.size(); i++){
+				std::free(blocks[i].data);
+			}
+		}
+
+		// copying an arena would mean two owners for every node
+		Arena(const Arena &) = delete;
+		Arena &operator=(const Arena &) = delete;
+
+		void *allocate(size_t size, size_t align){
+			size_t start = (used+align-1) & ~(align-1);
+			if(blocks.empty() || start+size>blocks[current].size){
+				newBlock(size+align);
+				start = 0;
+			}
+			void *p = blocks[current].data+start;
+			bytes += start+size-used;
+			used = start+size;
+			allocations++;
+			return p;
+		}
+
+		// use in place of new, eg arena.make<AddOperator>(left,right)
+		template<class T, class... Args>
+		T *make(Args&&... args){
+			void *p = allocate(sizeof(T),alignof(T));
+			T *object = new (p) T(std::forward<Args>(args)...);
+			if(!std::is_trivially_destructible<T>::value){
+				Finaliser f;
+				f.destroy = &destroy<T>;
+				f.object = object;
+				finalisers.push_back(f);
+			}
+			return object;
+		}
+
+		// destroys everything in the arena. The blocks are kept so the next translation unit can reuse them
+		void reset(){
+			for(size_t i=finalisers.size(); i>0; i--){
+				finalisers[i-1].destroy(finalisers[i-1].object);
+			}
+			finalisers.clear();
+			current = 0;
+			used = 0;
+			allocations = 0;
+			bytes = 0;
+		}
+
+		unsigned long objectCount() const { return allocations; }
+		unsigned long bytesUsed() const { return bytes; }
+		size_t blockCount() const { return blocks.size(); }
+		size_t bytesReserved() const {
+			size_t total = 0;
+			for(size_t i=0; i<blocks.size(); i++){
+				total += blocks[i].size;
+			}
+			return total;
+		}
+
+		void report(std::ostream &dst) const {
+			dst<<"arena: "<<allocations<<" objects, "<<bytes<<" bytes used in "<<blocks.size()<<" blocks ("
+				<<bytesReserved()<<" bytes reserved), "<<finalisers.size()<<" need destructors"<<std::endl;
+		}
+};
+
+#endif
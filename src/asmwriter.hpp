@@ -0,0 +1,126 @@
+#ifndef asmwriter_hpp
+#define asmwriter_hpp
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+/* Where the assembly goes. Everything is formatted straight into one big buffer, which is only
+	handed to the output stream when it passes the watermark and once more at the end, instead of the
+	stream being flushed after every line by std::endl. Numbers are formatted by hand and physical
+	register names come from a table, so printing an instruction makes no strings at all.
+
+	It takes << like an ostream for the few places that write directives, so those read the same as
+	before. Lines end with "\n", there is no endl.
+
+	A writer made without a stream just keeps everything, for text that is built on its own and
+	copied into the real one later (each function, when Program::compile runs them side by side).
+*/
+
+class AsmWriter{
+	protected:
+		std::ostream *sink; // NULL if this only collects
+		std::vector<char> buf;
+		size_t used;
+		size_t watermark;
+
+		void room(size_t n){ // make sure n more bytes fit
+			if(used+n>buf.size()){
+				buf.resize(std::max(buf.size()*2,used+n));
+			}
+		}
+
+	public:
+		static const size_t DEFAULT_WATERMARK = 1<<20;
+
+		AsmWriter(std::ostream &_sink, size_t _watermark = DEFAULT_WATERMARK) :
+			sink(&_sink), buf(_watermark+4096), used(0), watermark(_watermark){}
+		AsmWriter() : sink(NULL), buf(4096), used(0), watermark((size_t)-1){}
+		AsmWriter(const AsmWriter &) = delete;
+		AsmWriter &operator=(const AsmWriter &) = delete;
+		~AsmWriter(){
+			flush();
+		}
+
+		void flush(){
+			if(sink==NULL){
+				return;
+			}
+			if(used>0){
+				sink->write(&buf[0],used);
+				used = 0;
+			}
+			sink->flush();
+		}
+
+		// what has been written and not yet flushed, which for a writer without a stream is everything
+		const char *data() const { return &buf[0]; }
+		size_t size() const { return used; }
+
+		void put(char c){
+			room(1);
+			buf[used++] = c;
+		}
+		void put(const char *s, size_t n){
+			room(n);
+			std::memcpy(&buf[used],s,n);
+			used += n;
+		}
+		void put(const char *s){ put(s,std::strlen(s)); }
+		void put(const std::string &s){ put(s.data(),s.size()); }
+
+		void number(long v){
+			char digits[24];
+			int n = 0;
+			unsigned long u = v<0 ? 0ul-(unsigned long)v : (unsigned long)v; // no overflow for the most negative value
+			do{
+				digits[n++] = '0'+u%10;
+				u /= 10;
+			}while(u);
+			room(n+1);
+			if(v<0){
+				buf[used++] = '-';
+			}
+			while(n){
+				buf[used++] = digits[--n];
+			}
+		}
+
+		// physical registers, $0-$31, from a table
+		void reg(int r){
+			static const char names[32][4] = {
+				"$0","$1","$2","$3","$4","$5","$6","$7","$8","$9","$10","$11","$12","$13","$14","$15",
+				"$16","$17","$18","$19","$20","$21","$22","$23","$24","$25","$26","$27","$28","$29","$30","$31"
+			};
+			put(names[r],r<10 ? 2 : 3);
+		}
+
+		// a block of whole lines, like everything another writer (one without a stream) has collected
+		void append(const char *s, size_t n){
+			put(s,n);
+			if(used>=watermark){
+				flush();
+			}
+		}
+		void append(const AsmWriter &other){ append(other.data(),other.size()); }
+
+		// the end of a line is the other place the buffer is checked against the watermark
+		void endLine(){
+			put('\n');
+			if(used>=watermark){
+				flush();
+			}
+		}
+
+		AsmWriter &operator<<(char c){ if(c=='\n'){ endLine(); } else { put(c); } return *this; }
+		AsmWriter &operator<<(const char *s){ put(s); return *this; }
+		AsmWriter &operator<<(const std::string &s){ put(s); return *this; }
+		AsmWriter &operator<<(int v){ number(v); return *this; }
+		AsmWriter &operator<<(long v){ number(v); return *this; }
+		AsmWriter &operator<<(unsigned v){ number(v); return *this; }
+		AsmWriter &operator<<(unsigned long v){ number((long)v); return *this; }
+};
+
+#endif
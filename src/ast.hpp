@@ -2,7 +2,20 @@
 #define ast_hpp
 
 
+#include "trace.hpp" // debug output, used by every node
+#include "arena.hpp" // owns the nodes
+#include "session.hpp" // everything to do with one file
+#include "source.hpp" // and its text
 #include "context.hpp" // needs to be on top
+#include "asmwriter.hpp" // where the assembly is written
+#include "mips.hpp" // what function bodies compile into
+#include "emitter.hpp" // and how that is printed
+#include "cfg.hpp"
+#include "peephole.hpp"
+#include "regalloc.hpp"
+#include "scheduler.hpp"
+#include "threadpool.hpp" // for compiling functions side by side
+#include "incremental.hpp" // what each function compiled to last time
 #include "AST/ast_node.hpp"
 #include "AST/ast_expressions.hpp"
 #include "AST/ast_operators.hpp"
@@ -14,6 +27,7 @@
 
 
 
-extern const Node *parseAST(const char* location);
+extern const Node *parseAST(const char* location, Session &session);
+extern const Node *parseAST(SourceBuffer &source, Session &session);
 
 #endif
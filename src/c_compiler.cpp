@@ -6,8 +6,33 @@
 #include<sstream> // makes printing boiler plate somewhat quicker
 #include<cstdlib> //Required for exit
 #include<fstream> 
+#include<new>
+#include<vector>
+#include<chrono>
+#include<atomic>
+#include<memory>
+#include"threadpool.hpp"
+#include"cache.hpp"
 
 
+/* every heap allocation in the program goes through here, so --mem-report can show how many the
+	arena saves. Counting is all this adds on top of malloc. Atomic, since -j allocates from several threads */
+static std::atomic<unsigned long> heap_allocations(0);
+static std::atomic<unsigned long> heap_bytes(0);
+
+void *operator new(std::size_t size){
+	heap_allocations++;
+	heap_bytes += size;
+	void *p = std::malloc(size ? size : 1);
+	if(p==NULL){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
 /* when in python translate mode, this should be the start of every file */
 std::string make_boilerplate(){ 
 	std::stringstream ss; // make a function
@@ -16,35 +41,10 @@ std::string make_boilerplate(){
 	return ss.str();
 };
 
-int main(int argc, char *argv[]){
-	
-	//check for expected number of inputs
-	//program should be ran in form {location} {mode} {source} "-o" {dest}
-	if(argc<5){ //expected number
-		std::cerr<<"ERROR: Incorrect number of arguments provided"<<std::endl;
-		std::exit(1);
-	}
-	
-	//open dest file
-	
-	std::ofstream fileDest;
-	
-	fileDest.open(argv[4]); //the location of the dest file
-	if(!(fileDest.is_open())){ //if not opened then return error
-		std::cerr<<"Dest File "<<argv[2]<< " not found"<<std::endl; 
-		std::exit(1);//exit
-	}
-	
-	// get mode
-	std::string mode_select(argv[1]); // should be either "-S" or "--translate"
-	
-	
-	// Build AST
-	const Node *ast=parseAST(argv[2]); //Parse sorce file
-	
-	
-	//functionality
+/* compiles (or translates) one parsed file into dst */
+void compileUnit(const std::string &mode_select, const Node *ast, Session &session, std::ostream &fileDest){
 	if(mode_select =="--translate"){ //ie translator mode
+		PhaseTimer codegen(session.times,PHASE_CODEGEN); // python is written straight out, so this is output as well
 			
 		ast->translate(fileDest,0); 	/* call translate function on head of AST.
 												 the 0 means there is currently no indentation, as python uses
@@ -54,19 +54,374 @@ int main(int argc, char *argv[]){
 		fileDest<<std::endl;
 		fileDest<<make_boilerplate()<<std::endl;
 	}
-	else if(mode_select =="-S"){ //ie compile
+	else{ //ie compile, or stop before register allocation and dump each function's blocks
+		Context fake(&session);
+		FunctionCode toplevel("");  // each function makes its own, this is never written to
+		toplevel.emitIR = mode_select=="--emit-ir";
+		AsmWriter out(fileDest); // buffers everything, and only writes to the file in big pieces
+		//compile takes args of form (writer,context,code,int destReg, int returnLoc)
+		ast->compile(out,fake,toplevel,NO_REG,-1); // compiles into output file
+		PhaseTimer output(session.times,PHASE_OUTPUT);
+		out.flush();
+	}
+}
+
+/* in batch mode each output is named after its source, .c swapped for .s (or .py, or .ir), and
+	put next to it or in the directory given by -o */
+std::string outputName(const std::string &source, const std::string &mode_select, const char *dir){
+	std::string ext = mode_select=="--translate" ? ".py" : (mode_select=="--emit-ir" ? ".ir" : ".s");
+	std::string name = source;
+	size_t slash = name.find_last_of('/');
+	size_t dot = name.find_last_of('.');
+	if(dot!=std::string::npos && (slash==std::string::npos || dot>slash)){
+		name.erase(dot);
+	}
+	if(dir!=NULL){
+		name = std::string(dir)+"/"+(slash==std::string::npos ? name : name.substr(slash+1));
+	}
+	return name+ext;
+}
+
+// @file on the command line: every whitespace separated word in it is another source
+void readResponseFile(const char *location, std::vector<std::string> &sources){
+	std::ifstream list(location);
+	if(!list.is_open()){
+		std::cerr<<"Response File "<<location<<" not found"<<std::endl;
+		std::exit(1);
+	}
+	std::string path;
+	while(list>>path){
+		sources.push_back(path);
+	}
+}
+
+// what one file came to. In a batch these are kept until every file is done, so they can be listed in order
+struct UnitResult{
+	std::string output;
+	bool ok;
+	bool cached; // copied out of the cache, so never parsed
+	bool incremental; // went through a function index, see reused and compiled
+	unsigned long reused, compiled; // functions, with --incremental
+	double parseMs, totalMs;
+	unsigned long parseAllocations;
+	std::vector<unsigned long> peepholeHits;
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+/* reads, parses and compiles one file into dst. With a cache, a file that has been compiled the same way
+	before is copied straight out of it instead. With an index (--incremental, not for --translate), only
+	the functions that changed since it was written are compiled, and it is rewritten afterwards. Fills in
+	everything in result but the output name, and returns result.ok, which is false if the file could not
+	be read, parsed or compiled */
+bool compileSource(const char *location, const std::string &mode_select, Session &session, std::ostream &dst,
+		CompileCache *cache, const std::string &indexPath, UnitResult &result){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	result.ok = false;
+	result.cached = false;
+	result.incremental = false;
+	result.reused = result.compiled = 0;
+	result.parseMs = 0;
+	result.parseAllocations = 0;
+	SourceBuffer source; // NULL or "-" reads stdin
+	if(!source.load(location)){
+		std::cerr<<"Source File "<<(location ? location : "stdin")<<" could not be read"<<std::endl;
+		return false;
+	}
+	std::string key;
+	if(cache!=NULL){
+		PhaseTimer output(session.times,PHASE_OUTPUT); // a hit is all output
+		key = CompileCache::key(source.data(),source.textSize(),mode_select);
+		if(cache->fetch(key,dst)){
+			result.ok = result.cached = true;
+			result.totalMs = millisecondsSince(start);
+			return true;
+		}
+	}
+	unsigned long before = heap_allocations.load();
+	const Node *ast=parseAST(source,session);
+	result.parseAllocations = heap_allocations.load()-before;
+	result.parseMs = millisecondsSince(start);
+	if(ast==NULL){ // parseAST has already said why
+		session.text = NULL; // source goes when this returns
+		return false;
+	}
+	FunctionIndex index;
+	if(!indexPath.empty() && mode_select!="--translate"){
+		index.load(indexPath);
+		session.index = &index;
+		result.incremental = true;
+	}
+	if(cache==NULL){
+		compileUnit(mode_select,ast,session,dst);
+	}
+	else{ // kept whole, to go in the cache as well
+		std::ostringstream text;
+		compileUnit(mode_select,ast,session,text);
+		PhaseTimer output(session.times,PHASE_OUTPUT);
+		if(session.errors==0){ // so that the next run reports them again
+			cache->store(key,text.str());
+		}
+		dst<<text.str();
+	}
+	session.text = NULL; // the source and index both go when this returns
+	session.index = NULL;
+	if(session.errors>0){ // already printed by Session::error. The index is not saved either
+		return false;
+	}
+	if(result.incremental){
+		if(!index.save(indexPath)){
+			std::cerr<<"Index File "<<indexPath<<" could not be written"<<std::endl;
+		}
+		result.reused = index.reused;
+		result.compiled = index.compiled;
+	}
+	result.peepholeHits = session.peepholeHits;
+	result.totalMs = millisecondsSince(start);
+	result.ok = true;
+	return true;
+}
+
+// the same, with times (--time-report) for the whole run, which the file's phases are added to
+bool compileSource(const char *location, const std::string &mode_select, Session &session, std::ostream &dst,
+		CompileCache *cache, const std::string &indexPath, TimeReport *times, UnitResult &result){
+	TimeReport phases; // just this file's, so that parseAST can tell its own lexing from another thread's
+	if(times!=NULL){
+		session.times = &phases;
+		times->count(TALLY_FILES,1);
+	}
+	bool ok = compileSource(location,mode_select,session,dst,cache,indexPath,result);
+	if(times!=NULL){
+		session.times = NULL;
+		times->merge(phases);
+	}
+	return ok;
+}
+
+int main(int argc, char *argv[]){
+	
+	//program should be ran in form {location} {mode} {source} "-o" {dest}, mode is -S, --emit-ir or --translate
+	//optionally with -v (repeatable) and / or --trace=category,category anywhere on the line
+	//without a source (or with "-") it reads stdin, without -o it writes stdout, and without a mode it compiles,
+	//which is how test_bench.sh runs it
+	//with more than one source, or @listfile, it is in batch mode: see outputName for where each one goes.
+	//-j N then compiles N files at once. For a single file, it compiles N of its functions at once instead
+	//--incremental keeps each output's functions in output.idx, and next time only compiles the ones that changed
+	//--time-report (or --time-report=json) prints how long each phase took to stderr when done
+	std::string mode_select = "-S"; // should be "-S", "--emit-ir" or "--translate"
+	std::vector<std::string> sources;
+	bool batch = false;
+	const char *dest = NULL;
+	int verbosity = 0;
+	unsigned traced = 0;
+	bool mem_report = false; // print allocation counts to stderr when done
+	bool peephole_stats = false; // print how often each peephole rule fired to stderr when done
+	std::string cache_dir; // --cache=dir, empty for no cache
+	unsigned long long cache_limit = 256; // MB, --cache-size=
+	bool cache_stats = false; // print cache hits and misses to stderr when done
+	bool incremental = false; // a function index next to each output, see FunctionIndex
+	std::string time_report; // "table" or "json" for --time-report, empty for none
+	size_t jobs = 1; // files compiled at once in batch mode, or functions at once for a single file
+	
+	for(int i=1; i<argc; i++){
+		std::string arg(argv[i]);
+		if(arg=="-S" || arg=="--emit-ir" || arg=="--translate"){
+			mode_select = arg;
+		}
+		else if(arg=="-o" && i+1<argc){
+			dest = argv[++i];
+		}
+		else if(arg.size()>1 && arg[0]=='-' && arg.find_first_not_of('v',1)==std::string::npos){ // -v, -vv, -vvv
+			verbosity += arg.size()-1;
+		}
+		else if(arg=="--mem-report"){
+			mem_report = true;
+		}
+		else if(arg=="--peephole-stats"){
+			peephole_stats = true;
+		}
+		else if(arg.compare(0,8,"--cache=")==0){
+			cache_dir = arg.substr(8);
+		}
+		else if(arg.compare(0,13,"--cache-size=")==0){
+			cache_limit = std::strtoull(arg.c_str()+13,NULL,10);
+		}
+		else if(arg=="--cache-stats"){
+			cache_stats = true;
+		}
+		else if(arg=="--incremental"){
+			incremental = true;
+		}
+		else if(arg=="--time-report" || arg=="--time-report=table" || arg=="--time-report=json"){
+			time_report = arg.size()>13 ? arg.substr(14) : "table";
+		}
+		else if(arg.compare(0,8,"--trace=")==0){
+			if(!Trace::get().parseCategories(arg.substr(8),traced)){
+				std::cerr<<"ERROR: Unknown trace category in "<<arg<<std::endl;
+				std::exit(1);
+			}
+		}
+		else if(arg.compare(0,2,"-j")==0){ // -j N or -jN
+			const char *count = arg.size()>2 ? argv[i]+2 : (i+1<argc ? argv[++i] : "");
+			jobs = std::strtoul(count,NULL,10);
+			if(jobs==0){
+				std::cerr<<"ERROR: -j needs a number of jobs above 0"<<std::endl;
+				std::exit(1);
+			}
+		}
+		else if(arg.size()>1 && arg[0]=='@'){
+			readResponseFile(argv[i]+1,sources);
+			batch = true;
+		}
+		else if(arg.size()>1 && arg[0]=='-'){
+			std::cerr<<"ERROR: Unexpected argument "<<arg<<std::endl;
+			std::exit(1);
+		}
+		else{
+			sources.push_back(arg);
+		}
+	}
+	batch = batch || sources.size()>1;
+	if(batch && sources.empty()){
+		std::cerr<<"ERROR: No source files given"<<std::endl;
+		std::exit(1);
+	}
+	
+	if(incremental && !batch && dest==NULL){
+		std::cerr<<"Warning: --incremental needs -o, the index goes next to the output"<<std::endl;
+		incremental = false;
+	}
+	
+	#if !COMPILER_TRACE
+	if(verbosity || traced){
+		std::cerr<<"Warning: this build has tracing compiled out, rebuild with TRACE=1"<<std::endl;
+	}
+	#endif
+	Trace::get().configure(verbosity,traced);
+	
+	unsigned long parse_allocations = 0; // single file only, with -j the other threads' allocations would be counted too
+	std::vector<unsigned long> peephole_hits; // summed over every file
+	unsigned long long run_start = TimeReport::now();
+	std::unique_ptr<TimeReport> times(time_report.empty() ? NULL : new TimeReport);
+	std::unique_ptr<CompileCache> cache(cache_dir.empty() ? NULL : new CompileCache(cache_dir,cache_limit<<20));
+	WorkStealingPool pool(batch && jobs<sources.size() ? jobs : (batch ? sources.size() : 1));
+	std::vector<Arena> arenas(pool.size()); // one per worker, owns every node. Reset between files, keeping its blocks
+	std::vector<Interner> interners(pool.size()); // one per worker, every identifier it has seen. Kept from one file to the next
+	
+	if(!batch){
+		//open dest file
 		
+		std::ofstream destFile;
 		
-		Registers regs;
-		Context fake;
-		std::string foo = "NULL"; // destReg and returnLoc both invalid right now
-		//compile takes args of form (ostream,context,registers,string destReg, string returnLoc)
-		ast->compile(fileDest,fake,regs,foo,foo); // compiles into output file
+		if(dest!=NULL){
+			destFile.open(dest); //the location of the dest file
+			if(!(destFile.is_open())){ //if not opened then return error
+				std::cerr<<"Dest File "<<dest<< " not found"<<std::endl; 
+				std::exit(1);//exit
+			}
+		}
+		std::ostream &fileDest = dest!=NULL ? destFile : std::cout;
+		
+		// Build AST
+		Session session(arenas[0],interners[0]); // everything else that belongs to this file
+		session.threads = jobs;
+		UnitResult result;
+		std::string indexPath = incremental ? std::string(dest)+".idx" : "";
+		if(!compileSource(sources.empty() ? NULL : sources[0].c_str(),mode_select,session,fileDest,cache.get(),indexPath,times.get(),result)){ //sorce file, or stdin if there is none
+			if(dest!=NULL){
+				destFile.close();
+				std::remove(dest); // no half written output left behind
+			}
+			std::exit(1);
+		}
+		if(cache_stats && result.incremental){
+			std::cerr<<"functions: "<<result.reused<<" reused, "<<result.compiled<<" compiled"<<std::endl;
+		}
+		parse_allocations = result.parseAllocations;
+		peephole_hits = result.peepholeHits;
 	}
-	
 	else{
-		std::cerr<<"ERROR: Invalid command"<<std::endl;
-		std::exit(1); // no error code was ever specified, so I just chose this
+		std::chrono::steady_clock::time_point batchStart = std::chrono::steady_clock::now();
+		std::vector<UnitResult> results(sources.size());
+		pool.run(sources.size(),[&](size_t worker, size_t f){
+			UnitResult &result = results[f];
+			arenas[worker].reset(); // this worker's last file is finished with
+			Session session(arenas[worker],interners[worker]);
+			result.output = outputName(sources[f],mode_select,dest);
+			std::ofstream fileDest(result.output.c_str());
+			if(!fileDest.is_open()){
+				std::cerr<<"Dest File "<<result.output<<" not found"<<std::endl;
+				result.ok = false;
+				return;
+			}
+			if(!compileSource(sources[f].c_str(),mode_select,session,fileDest,cache.get(),incremental ? result.output+".idx" : "",times.get(),result)){
+				fileDest.close();
+				std::remove(result.output.c_str()); // no half written output left behind
+			}
+		});
+		
+		int failed = 0; // a file that does not parse is skipped, the rest still get compiled
+		for(size_t f=0; f<sources.size(); f++){
+			const UnitResult &result = results[f];
+			if(!result.ok){
+				std::cerr<<sources[f]<<": failed"<<std::endl;
+				failed++;
+				continue;
+			}
+			peephole_hits.resize(result.peepholeHits.size(),0);
+			for(size_t r=0; r<result.peepholeHits.size(); r++){
+				peephole_hits[r] += result.peepholeHits[r];
+			}
+			std::cerr<<sources[f]<<" -> "<<result.output<<": ";
+			if(result.cached){
+				std::cerr<<"from the cache, "<<result.totalMs<<" ms"<<std::endl;
+			}
+			else{
+				std::cerr<<result.parseMs<<" ms parsing, "<<result.totalMs<<" ms in total";
+				if(result.incremental){
+					std::cerr<<", "<<result.reused<<" functions reused, "<<result.compiled<<" compiled";
+				}
+				std::cerr<<std::endl;
+			}
+		}
+		std::cerr<<"batch: "<<sources.size()<<" files in "<<millisecondsSince(batchStart)<<" ms";
+		if(pool.size()>1){
+			std::cerr<<" on "<<pool.size()<<" threads";
+		}
+		if(failed){
+			std::cerr<<", "<<failed<<" failed";
+		}
+		std::cerr<<std::endl;
+		if(failed){
+			return 1;
+		}
+	}
+	
+	if(mem_report){
+		for(size_t w=0; w<arenas.size(); w++){
+			arenas[w].report(std::cerr);
+		}
+		std::cerr<<"heap: ";
+		if(!batch){
+			std::cerr<<parse_allocations<<" allocations while parsing, ";
+		}
+		std::cerr<<heap_allocations.load()<<" in total ("<<heap_bytes.load()<<" bytes)"<<std::endl;
+	}
+	if(peephole_stats){
+		Peephole::report(std::cerr,peephole_hits);
+	}
+	if(cache_stats && cache){
+		cache->report(std::cerr);
+	}
+	if(times){
+		if(time_report=="json"){
+			times->printJSON(std::cerr,TimeReport::now()-run_start);
+		}
+		else{
+			times->print(std::cerr,TimeReport::now()-run_start);
+		}
 	}
 	
 	return 0;
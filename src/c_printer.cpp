@@ -9,11 +9,17 @@ int main(int argc, char *argv[]){
 		std::cerr<<"ERROR, expected more arguments"<<std::endl;
 		std::exit(1);
 	}
-	const Node *ast=parseAST(argv[1]); // parse AST
+	Arena arena; // holds the tree
+	Interner interner;
+	Session session(arena,interner);
+	const Node *ast=parseAST(argv[1],session); // parse AST
 	//error checking
-	std::cerr<<"I parsed the tree"<<std::endl;
+	if(ast==NULL){
+		std::exit(1);
+	}
+	TRACE(TRACE_PARSER, TRACE_INFO, "I parsed the tree");
 	ast->print(std::cout); //Print implemented on some nodes. Was not a requirement so patchy and incomplete
-	std::cerr<<"I am trying to print"<<std::endl;
+	TRACE(TRACE_PARSER, TRACE_INFO, "I am trying to print");
     std::cout<<std::endl;
 	
 	return 0;
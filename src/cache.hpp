@@ -0,0 +1,212 @@
+#ifndef cache_hpp
+#define cache_hpp
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <functional>
+
+// makefile passes the git revision in, so a rebuilt compiler does not use output from an old one
+#ifndef COMPILER_VERSION
+#define COMPILER_VERSION "unknown"
+#endif
+
+/* An on disk cache of compiled output (--cache=dir), so a file that has not changed since it was last
+	compiled is copied out instead of being lexed, parsed and compiled again. The key is the 128 bit FNV-1a
+	hash of the source, the compiler's version and build time, and the mode (-S, --emit-ir or --translate).
+	Nothing else on the command line changes the output. Each entry is one file named by its key.
+
+	Several compilers can share a directory. An entry is written to a temporary name and renamed into
+	place, which is atomic, so nobody ever reads half of one. A hit sets the entry's modification time to
+	now. The directory is only listed on the first store, to find how much is in it, and after that each
+	store adds its size. Once that goes over the limit, it is listed again (other compilers may have
+	stored or evicted since) and the oldest entries are deleted until it fits, which makes it least
+	recently used. An entry deleted between being found and being read is just a miss. Temporaries left
+	by a compiler that died before renaming them are deleted whenever the directory is listed.
+*/
+
+class CompileCache{
+	protected:
+		std::string dir;
+		unsigned long long limit; // bytes
+		std::atomic<unsigned long> hits, misses, stores, evictions;
+		std::mutex lock; // for the running size, stores can come from several threads
+		unsigned long long used; // bytes in entries, as far as this process knows
+		bool listed; // used has been counted from the directory
+
+		static const int KEY_DIGITS = 32;
+		static const time_t STALE_SECONDS = 3600; // a temporary this old belongs to nobody any more
+
+		// 128 bit FNV-1a, h[0] the top half. The prime is 2^88+0x13b, so multiplying by it is one small
+		// multiply and a shift, done in 64 bit halves
+		static void fnv1a(uint64_t h[2], const char *data, size_t n){
+			for(size_t i=0; i<n; i++){
+				h[1] ^= (unsigned char)data[i];
+				uint64_t carry = ((h[1]>>32)*0x13b+(((h[1]&0xffffffffull)*0x13b)>>32))>>32;
+				h[0] = h[0]*0x13b+carry+(h[1]<<24);
+				h[1] *= 0x13b;
+			}
+		}
+
+		std::string path(const std::string &key) const { return dir+"/"+key; }
+
+		// an entry's name is its key, a temporary's is the key followed by a dot and who was writing it
+		static bool isKey(const std::string &name, size_t n){
+			if(n!=KEY_DIGITS || name.size()<n){
+				return false;
+			}
+			for(size_t i=0; i<n; i++){
+				if(!std::isxdigit((unsigned char)name[i])){
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/* lists the directory: deletes stale temporaries, and counts what is in the entries. With evict,
+			deletes the least recently used entries until everything fits in the limit again. Called with
+			the lock held */
+		void list(bool evict){
+			struct Entry{
+				std::string name;
+				time_t used;
+				unsigned long long size;
+				bool operator<(const Entry &other) const { return used<other.used; }
+			};
+			std::vector<Entry> entries;
+			unsigned long long total = 0;
+			time_t now = std::time(NULL);
+			DIR *d = opendir(dir.c_str());
+			if(d==NULL){
+				return;
+			}
+			while(struct dirent *e = readdir(d)){
+				std::string name = e->d_name;
+				struct stat info;
+				if(!isKey(name,std::min(name.find('.'),name.size())) || stat(path(name).c_str(),&info)!=0){ // not . and .., or anything else
+					continue;
+				}
+				if(name.size()!=KEY_DIGITS){ // a temporary, which is only there for a moment unless its writer died
+					if(now-info.st_mtime>STALE_SECONDS){
+						std::remove(path(name).c_str());
+					}
+					continue;
+				}
+				Entry entry = {name,info.st_mtime,(unsigned long long)info.st_size};
+				entries.push_back(entry);
+				total += entry.size;
+			}
+			closedir(d);
+			if(evict){
+				std::sort(entries.begin(),entries.end());
+				for(size_t i=0; i<entries.size() && total>limit; i++){
+					if(std::remove(path(entries[i].name).c_str())==0){
+						evictions++;
+					}
+					total -= entries[i].size;
+				}
+			}
+			used = total;
+			listed = true;
+		}
+
+	public:
+		CompileCache(const std::string &_dir, unsigned long long _limit) :
+			dir(_dir), limit(_limit), hits(0), misses(0), stores(0), evictions(0), used(0), listed(false){
+			mkdir(dir.c_str(),0777); // fails harmlessly if it is already there
+		}
+
+		// which compiler made something. Output from any other build never matches
+		static std::string build(){
+			return std::string(COMPILER_VERSION)+" "+__DATE__+" "+__TIME__;
+		}
+
+		// 32 hex digits for the text, given everything else that decides what it compiles to
+		static std::string hash(const std::string &context, const char *text, size_t n){
+			uint64_t h[2] = {0x6c62272e07bb0142ull,0x62b821756295c58dull};
+			char digits[KEY_DIGITS+1];
+			fnv1a(h,context.data(),context.size()+1); // the 0 on the end keeps the context and text apart
+			fnv1a(h,text,n);
+			std::snprintf(digits,sizeof(digits),"%016llx%016llx",(unsigned long long)h[0],(unsigned long long)h[1]);
+			return digits;
+		}
+
+		static std::string key(const char *source, size_t n, const std::string &mode){
+			return hash(build()+" "+mode,source,n);
+		}
+
+		// copies the entry for key into dst, mapped rather than read. False if there is none
+		bool fetch(const std::string &key, std::ostream &dst){
+			int fd = open(path(key).c_str(),O_RDONLY);
+			struct stat info;
+			if(fd<0 || fstat(fd,&info)!=0){
+				if(fd>=0){
+					close(fd);
+				}
+				misses++;
+				return false;
+			}
+			if(info.st_size>0){
+				void *text = mmap(NULL,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+				if(text==MAP_FAILED){
+					close(fd);
+					misses++;
+					return false;
+				}
+				dst.write((const char *)text,info.st_size);
+				munmap(text,info.st_size);
+			}
+			close(fd);
+			utime(path(key).c_str(),NULL); // now the most recently used
+			hits++;
+			return true;
+		}
+
+		void store(const std::string &key, const std::string &text){
+			std::string temp = path(key)+"."+std::to_string(getpid())+"."+std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+			FILE *out = std::fopen(temp.c_str(),"wb");
+			if(out==NULL){
+				return;
+			}
+			bool ok = std::fwrite(text.data(),1,text.size(),out)==text.size();
+			ok = std::fclose(out)==0 && ok;
+			std::lock_guard<std::mutex> hold(lock);
+			struct stat replaced; // another compiler got there first, and this takes the place of its entry
+			unsigned long long gone = stat(path(key).c_str(),&replaced)==0 ? replaced.st_size : 0;
+			if(!ok || std::rename(temp.c_str(),path(key).c_str())!=0){
+				std::remove(temp.c_str());
+				return;
+			}
+			stores++;
+			if(!listed){
+				list(false); // counts this entry as well
+			}
+			else{
+				used = used-std::min(gone,used)+text.size();
+			}
+			if(used>limit){
+				list(true);
+			}
+		}
+
+		void report(std::ostream &dst) const {
+			dst<<"cache: "<<hits.load()<<" hits, "<<misses.load()<<" misses, "<<stores.load()<<" stored, "
+				<<evictions.load()<<" evicted"<<std::endl;
+		}
+};
+
+#endif
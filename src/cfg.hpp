@@ -0,0 +1,108 @@
+#ifndef cfg_hpp
+#define cfg_hpp
+
+#include <vector>
+#include "mips.hpp"
+#include "emitter.hpp"
+
+/* The control flow graph of a FunctionCode. The instructions stay where they are, in the one flat
+	vector, and a block is just the range of indices [first,last] in it. A block starts at a label
+	or straight after a branch, and ends at a branch or just before the next label. Calls come back,
+	so they do not end a block.
+
+	Anything that needs the whole function's flow (liveness in regalloc.hpp, anything that folds or
+	removes code) builds one of these. Nothing keeps it up to date, so build it again after changing
+	the instructions.
+*/
+
+struct BasicBlock{
+	int first, last; // instruction indices, inclusive
+	std::vector<int> succs; // block numbers, the branch target first, then the fall through
+	std::vector<int> preds;
+};
+
+class ControlFlowGraph{
+	protected:
+		const FunctionCode &code;
+
+		void build(){
+			const std::vector<MInstr> &in = code.instrs;
+			size_t start = 0;
+			for(size_t i=0; i<in.size(); i++){
+				if(i+1==in.size() || in[i].endsBlock() || in[i+1].op==OP_LABEL){
+					BasicBlock b;
+					b.first = start;
+					b.last = i;
+					blocks.push_back(b);
+					start = i+1;
+				}
+			}
+			std::vector<int> labelBlock; // block that starts with label sym
+			for(size_t b=0; b<blocks.size(); b++){
+				const MInstr &head = in[blocks[b].first];
+				if(head.op==OP_LABEL){
+					if((size_t)head.sym>=labelBlock.size()){
+						labelBlock.resize(head.sym+1,-1);
+					}
+					labelBlock[head.sym] = b;
+				}
+			}
+			for(size_t b=0; b<blocks.size(); b++){
+				const MInstr &tail = in[blocks[b].last];
+				OperandFormat f = opcodeInfo(tail.op).format;
+				if((f==F_BRANCH || f==F_JUMP) && (size_t)tail.sym<labelBlock.size() && labelBlock[tail.sym]>=0){
+					blocks[b].succs.push_back(labelBlock[tail.sym]);
+				}
+				if(tail.fallsThrough() && b+1<blocks.size()){
+					blocks[b].succs.push_back(b+1);
+				}
+			}
+			for(size_t b=0; b<blocks.size(); b++){
+				for(size_t s=0; s<blocks[b].succs.size(); s++){
+					blocks[blocks[b].succs[s]].preds.push_back(b);
+				}
+			}
+		}
+
+		static void printList(AsmWriter &dst, const std::vector<int> &list){
+			for(size_t k=0; k<list.size(); k++){
+				dst<<(k ? "," : "")<<"B"<<list[k];
+			}
+		}
+
+	public:
+		std::vector<BasicBlock> blocks; // in the order they are laid out
+
+		ControlFlowGraph(const FunctionCode &_code) : code(_code){
+			build();
+		}
+
+		size_t size() const { return blocks.size(); }
+		const BasicBlock &operator[](size_t b) const { return blocks[b]; }
+
+		// for --emit-ir, the blocks with their edges and instructions, registers still virtual
+		void print(AsmWriter &dst) const {
+			dst<<"function "<<code.name<<", "<<code.regCount()-FIRST_VREG<<" virtual registers, "<<blocks.size()<<" blocks"<<'\n';
+			for(size_t b=0; b<blocks.size(); b++){
+				dst<<"B"<<b<<":";
+				if(!blocks[b].preds.empty()){
+					dst<<"\tfrom ";
+					printList(dst,blocks[b].preds);
+				}
+				dst<<'\n';
+				for(int i=blocks[b].first; i<=blocks[b].last; i++){
+					if(code.instrs[i].op!=OP_LABEL){
+						dst<<"\t";
+					}
+					MipsEmitter::instr(dst,code,code.instrs[i]);
+				}
+				if(!blocks[b].succs.empty()){
+					dst<<"\t-> ";
+					printList(dst,blocks[b].succs);
+					dst<<'\n';
+				}
+			}
+		}
+};
+
+#endif
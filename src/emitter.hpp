@@ -0,0 +1,102 @@
+#ifndef emitter_hpp
+#define emitter_hpp
+
+#include "mips.hpp"
+#include "asmwriter.hpp"
+
+/* Turns a FunctionCode into assembly text. This is the only place that knows how an instruction is
+	written out, the passes before it only ever see MInstrs. Registers are printed by number, so
+	anything still virtual comes out as $vN, which is what --emit-ir shows. It all goes into an
+	AsmWriter (asmwriter.hpp), never straight to a stream.
+*/
+
+class MipsEmitter{
+	public:
+		static void printReg(AsmWriter &dst, int reg){
+			if(reg>=FIRST_VREG){
+				dst<<"$v"<<reg-FIRST_VREG; // only seen in --emit-ir and debug output, before allocation
+			}
+			else{
+				dst.reg(reg);
+			}
+		}
+
+		static void instr(AsmWriter &dst, const FunctionCode &code, const MInstr &i){
+			const OpcodeInfo &info = opcodeInfo(i.op);
+			if(i.op==OP_LABEL){
+				dst<<code.symbolName(i.sym)<<":"<<'\n';
+				return;
+			}
+			if(i.op==OP_LI && (i.imm<-32768 || i.imm>65535)){ // a wide constant, which li would be anyway. Spelt out so the listing shows both
+				dst<<"lui "; printReg(dst,i.rd); dst<<", "<<((unsigned)i.imm>>16)<<'\n';
+				if(i.imm & 0xffff){
+					dst<<"ori "; printReg(dst,i.rd); dst<<", "; printReg(dst,i.rd); dst<<", "<<(i.imm & 0xffff)<<'\n';
+				}
+				return;
+			}
+			dst<<info.name;
+			switch(info.format){
+				case F_RRR:
+					dst<<" "; printReg(dst,i.rd); dst<<", "; printReg(dst,i.rs); dst<<", "; printReg(dst,i.rt);
+					break;
+				case F_RRI:
+					dst<<" "; printReg(dst,i.rd); dst<<", "; printReg(dst,i.rs); dst<<", "<<i.imm;
+					break;
+				case F_RI:
+					dst<<" "; printReg(dst,i.rd); dst<<", ";
+					if(i.sym>=0){
+						dst<<"%hi("<<code.symbolName(i.sym)<<")";
+					}
+					else{
+						dst<<i.imm;
+					}
+					break;
+				case F_RR:
+					dst<<" "; printReg(dst,i.rd); dst<<", "; printReg(dst,i.rs);
+					break;
+				case F_LOAD: case F_STORE:
+					dst<<" "; printReg(dst,info.format==F_LOAD ? i.rd : i.rt); dst<<", ";
+					if(i.sym>=0){
+						dst<<"%lo("<<code.symbolName(i.sym)<<")";
+					}
+					else{
+						dst<<i.imm;
+					}
+					dst<<"("; printReg(dst,i.rs); dst<<")";
+					break;
+				case F_HILO:
+					dst<<" "<<(i.op==OP_DIV ? "$0, " : ""); printReg(dst,i.rs); dst<<", "; printReg(dst,i.rt); // div with $0 first is never expanded into a checked macro
+					break;
+				case F_MF:
+					dst<<" "; printReg(dst,i.rd);
+					break;
+				case F_BRANCH:
+					dst<<" "; printReg(dst,i.rs); dst<<", "; printReg(dst,i.rt); dst<<", "<<code.symbolName(i.sym);
+					break;
+				case F_JUMP: case F_CALL:
+					dst<<" "<<code.symbolName(i.sym);
+					break;
+				case F_JR:
+					dst<<" "; printReg(dst,i.rs);
+					break;
+				default:
+					break;
+			}
+			dst<<'\n';
+		}
+
+		// a whole function, once it has been through the register allocator and the scheduler
+		static void function(AsmWriter &dst, const FunctionCode &code){
+			dst<<"\t.globl\t"<<code.name<<'\n';
+			dst<<"\t.ent\t"<<code.name<<'\n';
+			dst<<code.name<<":"<<'\n';
+			dst<<"\t.set\tnoreorder"<<'\n'; // the delay slots are already filled, the assembler must not move anything
+			for(size_t i=0; i<code.instrs.size(); i++){
+				instr(dst,code,code.instrs[i]);
+			}
+			dst<<"\t.set\treorder"<<'\n';
+			dst<<"\t.end\t"<<code.name<<'\n';
+		}
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef incremental_hpp
+#define incremental_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include "cache.hpp"
+#include "source.hpp"
+
+/* --incremental keeps the assembly of every function of a file in a sidecar index next to the output
+	(name.s.idx), keyed by a hash of what the function compiles from. Next time the file is compiled,
+	a function whose key is in the index is copied from there, and only the others are compiled again.
+	See Program::compile.
+
+	A function's assembly depends on its own text, and on which of the names in it are globals, since
+	those are loaded from memory instead of a register. So the key is a hash of the function's source,
+	the globals it names, the mode and the compiler build. Nothing else matters: a call is just a jal
+	to the name, whatever the callee looks like.
+
+	The file is plain text: a header line, then for each function its key and length on one line
+	followed by that many bytes of assembly. It is rewritten after every compile with only the
+	functions the file has now, through a temporary name and a rename like the cache.
+*/
+
+class FunctionIndex{
+	protected:
+		static const char *header(){ return "c89-function-index 1"; }
+
+		std::string previous; // all of the old index file
+		std::unordered_map<std::string,std::pair<size_t,size_t> > entries; // key to where its text is in previous
+		std::string next; // the new index, built up as the file is compiled
+
+	public:
+		unsigned long reused, compiled;
+
+		FunctionIndex() : reused(0), compiled(0){
+			next = std::string(header())+"\n";
+		}
+
+		// reads the index from last time. A missing or damaged one just means every function is compiled
+		void load(const std::string &location){
+			SourceBuffer file;
+			if(!file.load(location.c_str())){
+				return;
+			}
+			previous.assign(file.data(),file.textSize());
+			size_t pos = previous.find('\n');
+			if(pos==std::string::npos || previous.compare(0,pos,header())!=0){
+				return;
+			}
+			pos++;
+			while(pos<previous.size()){ // not sscanf, which measures the whole rest of the string every time
+				size_t eol = previous.find('\n',pos);
+				size_t space = previous.find(' ',pos);
+				if(eol==std::string::npos || space>eol){
+					break;
+				}
+				char *end;
+				size_t length = std::strtoul(previous.c_str()+space+1,&end,10);
+				if(end!=previous.c_str()+eol || eol+1+length>previous.size()){
+					break;
+				}
+				entries[previous.substr(pos,space-pos)] = std::make_pair(eol+1,length);
+				pos = eol+1+length;
+			}
+		}
+
+		bool save(const std::string &location) const {
+			std::string temp = location+".tmp";
+			FILE *out = std::fopen(temp.c_str(),"wb");
+			if(out==NULL){
+				return false;
+			}
+			bool ok = std::fwrite(next.data(),1,next.size(),out)==next.size();
+			ok = std::fclose(out)==0 && ok;
+			if(!ok || std::rename(temp.c_str(),location.c_str())!=0){
+				std::remove(temp.c_str());
+				return false;
+			}
+			return true;
+		}
+
+		// the key for a function with this source. globals is every global in the file
+		static std::string key(const char *text, size_t n, const std::unordered_set<std::string> &globals, bool emitIR){
+			std::string context = CompileCache::build()+(emitIR ? " --emit-ir" : " -S");
+			std::unordered_set<std::string> seen;
+			for(size_t i=0; i<n; ){ // every identifier, the same way the lexer finds them
+				if(!std::isalpha((unsigned char)text[i])){
+					i++;
+					continue;
+				}
+				size_t start = i;
+				while(i<n && std::isalnum((unsigned char)text[i])){
+					i++;
+				}
+				std::string name(text+start,i-start);
+				if(globals.count(name) && seen.insert(name).second){
+					context += " "+name;
+				}
+			}
+			return CompileCache::hash(context,text,n);
+		}
+
+		// the assembly stored for key last time, or false
+		bool find(const std::string &key, const char *&text, size_t &length) const {
+			std::unordered_map<std::string,std::pair<size_t,size_t> >::const_iterator pos = entries.find(key);
+			if(pos==entries.end()){
+				return false;
+			}
+			text = previous.data()+pos->second.first;
+			length = pos->second.second;
+			return true;
+		}
+
+		// a function of this compile, in the order they are written out
+		void record(const std::string &key, const char *text, size_t length){
+			next += key+" "+std::to_string(length)+"\n";
+			next.append(text,length);
+		}
+};
+
+#endif
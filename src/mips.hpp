@@ -0,0 +1,219 @@
+#ifndef mips_hpp
+#define mips_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* The lowered form of one function. Nodes no longer print MIPS text as they go, they append
+	MInstrs to a FunctionCode. Registers in here are either physical (0-31) or virtual (32 up,
+	handed out by newReg). Nothing is printed until the register allocator (regalloc.hpp) has
+	replaced every virtual register and added the prologue and epilogue, and the scheduler
+	(scheduler.hpp) has filled in the delay slots. Branches are listed without them until then.
+	Printing is done by emitter.hpp, and cfg.hpp splits the instructions into basic blocks.
+*/
+
+enum Opcode{
+	// rd = rs op rt
+	OP_ADDU, OP_SUBU, OP_AND, OP_OR, OP_XOR, OP_NOR, OP_SLT, OP_SLTU, OP_SLLV, OP_SRAV,
+	// rd = rs op imm
+	OP_ADDIU, OP_ANDI, OP_ORI, OP_XORI, OP_SLTI, OP_SLTIU, OP_SLL, OP_SRA,
+	OP_LI, // rd = imm
+	OP_LUI, // rd = imm<<16, or %hi(sym)
+	OP_MOVE, // rd = rs
+	OP_LW, // rd = imm(rs), or %lo(sym)(rs)
+	OP_SW, // imm(rs) = rt, or %lo(sym)(rs)
+	OP_MULT, OP_DIV, // hi,lo = rs op rt
+	OP_MFLO, // rd = lo
+	OP_BEQ, OP_BNE, // to label sym if rs ==/!= rt
+	OP_B, // to label sym
+	OP_JAL, // call function sym
+	OP_JR, // jump to rs
+	OP_NOP,
+	OP_LABEL, // not an instruction, marks label sym
+	OP_COUNT
+};
+
+enum OperandFormat{ // which fields an opcode uses, and how it is printed
+	F_RRR, // rd, rs, rt
+	F_RRI, // rd, rs, imm
+	F_RI, // rd, imm
+	F_RR, // rd, rs
+	F_LOAD, // rd, imm(rs)
+	F_STORE, // rt, imm(rs)
+	F_HILO, // rs, rt
+	F_MF, // rd
+	F_BRANCH, // rs, rt, label
+	F_JUMP, // label
+	F_CALL, // function
+	F_JR, // rs
+	F_NONE,
+	F_LABEL
+};
+
+struct OpcodeInfo{
+	const char *name;
+	OperandFormat format;
+};
+
+inline const OpcodeInfo &opcodeInfo(Opcode op){
+	static const OpcodeInfo table[OP_COUNT] = {
+		{"addu",F_RRR},{"subu",F_RRR},{"and",F_RRR},{"or",F_RRR},{"xor",F_RRR},{"nor",F_RRR},{"slt",F_RRR},{"sltu",F_RRR},{"sllv",F_RRR},{"srav",F_RRR},
+		{"addiu",F_RRI},{"andi",F_RRI},{"ori",F_RRI},{"xori",F_RRI},{"slti",F_RRI},{"sltiu",F_RRI},{"sll",F_RRI},{"sra",F_RRI},
+		{"li",F_RI},
+		{"lui",F_RI},
+		{"move",F_RR},
+		{"lw",F_LOAD},
+		{"sw",F_STORE},
+		{"mult",F_HILO},{"div",F_HILO},
+		{"mflo",F_MF},
+		{"beq",F_BRANCH},{"bne",F_BRANCH},
+		{"b",F_JUMP},
+		{"jal",F_CALL},
+		{"jr",F_JR},
+		{"nop",F_NONE},
+		{"",F_LABEL}
+	};
+	return table[op];
+}
+
+// whether imm can be the immediate of op. addiu, slti and sltiu sign extend theirs, andi, ori and xori do not
+inline bool fitsImmediate(Opcode op, int imm){
+	switch(op){
+		case OP_ADDIU: case OP_SLTI: case OP_SLTIU:
+			return imm>=-32768 && imm<=32767;
+		case OP_ANDI: case OP_ORI: case OP_XORI:
+			return imm>=0 && imm<=65535;
+		case OP_SLL: case OP_SRA:
+			return imm>=0 && imm<=31;
+		default:
+			return false;
+	}
+}
+
+const int NO_REG = -1; // in place of the old "NULL" register string
+const int FIRST_VREG = 32; // registers numbered from here up are virtual
+
+struct MInstr{
+	Opcode op;
+	int rd, rs, rt; // -1 where the format does not use them
+	int imm;
+	int sym; // index into FunctionCode::names for labels, globals and call targets, -1 if not used
+
+	bool isBranch() const { // anything with a delay slot, see scheduler.hpp
+		OperandFormat f = opcodeInfo(op).format;
+		return f==F_BRANCH || f==F_JUMP || f==F_CALL || f==F_JR;
+	}
+
+	bool endsBlock() const { // control does not simply carry on to the next instruction. Calls come back, so they do not count
+		OperandFormat f = opcodeInfo(op).format;
+		return f==F_BRANCH || f==F_JUMP || f==F_JR;
+	}
+	bool fallsThrough() const {
+		OperandFormat f = opcodeInfo(op).format;
+		return f!=F_JUMP && f!=F_JR;
+	}
+
+	// the register written, or NO_REG
+	int def() const {
+		switch(opcodeInfo(op).format){
+			case F_RRR: case F_RRI: case F_RI: case F_RR: case F_LOAD: case F_MF:
+				return rd;
+			default:
+				return NO_REG;
+		}
+	}
+
+	// the registers read, returns how many (at most two) were put in out
+	int uses(int out[2]) const {
+		switch(opcodeInfo(op).format){
+			case F_RRR: case F_HILO: case F_BRANCH:
+				out[0]=rs; out[1]=rt; return 2;
+			case F_STORE:
+				out[0]=rt; out[1]=rs; return 2;
+			case F_RRI: case F_RR: case F_LOAD: case F_JR:
+				out[0]=rs; return 1;
+			default:
+				return 0;
+		}
+	}
+};
+
+class FunctionCode{
+	protected:
+		std::vector<std::string> names; // labels, globals and functions referred to
+		std::unordered_map<std::string,int> symbols; // name to index in names
+		int nextReg;
+		int nextLabel;
+		std::vector<bool> variable; // variable[v-FIRST_VREG] is true if v holds a C variable rather than a temporary
+
+	public:
+		std::string name; // the function's own name
+		std::vector<MInstr> instrs;
+		int returnLabel;
+		bool emitIR; // --emit-ir, set on the top level FunctionCode and copied by each function from there
+
+		FunctionCode(const std::string &_name) : nextReg(FIRST_VREG), nextLabel(0), name(_name), returnLabel(-1), emitIR(false){}
+
+		int newReg(){ // a fresh temporary
+			variable.push_back(false);
+			return nextReg++;
+		}
+		int newVariableReg(){ // a fresh register to keep a variable in for its whole life
+			variable.push_back(true);
+			return nextReg++;
+		}
+		int regCount() const { return nextReg; }
+		bool isVariable(int reg) const { return reg>=FIRST_VREG && variable[reg-FIRST_VREG]; }
+
+		int symbol(const std::string &text){ // labels and symbols share one table, labels are made unique by their callers
+			std::unordered_map<std::string,int>::iterator pos = symbols.find(text);
+			if(pos!=symbols.end()){
+				return pos->second;
+			}
+			names.push_back(text);
+			symbols[text] = names.size()-1;
+			return names.size()-1;
+		}
+		const std::string &symbolName(int sym) const { return names[sym]; }
+
+		// labels are numbered per function, and the function's name on the end keeps them apart from every
+		// other function's, so functions can be compiled in any order, or at once. stem is what it is for, "$if_f"
+		int newLabel(){ return nextLabel++; }
+		int labelSymbol(const std::string &stem, int n){ return symbol(stem+std::to_string(n)+"_"+name); }
+
+		void emit(Opcode op, int rd, int rs, int rt, int imm, int sym){
+			MInstr i = {op,rd,rs,rt,imm,sym};
+			instrs.push_back(i);
+		}
+
+		//shorthands, roughly one per operand format
+		void op3(Opcode op, int rd, int rs, int rt){ emit(op,rd,rs,rt,0,-1); }
+		void opImm(Opcode op, int rd, int rs, int imm){ emit(op,rd,rs,NO_REG,imm,-1); }
+		void li(int rd, int imm){ emit(OP_LI,rd,NO_REG,NO_REG,imm,-1); }
+		void move(int rd, int rs){ emit(OP_MOVE,rd,rs,NO_REG,0,-1); }
+		void lw(int rd, int offset, int base){ emit(OP_LW,rd,base,NO_REG,offset,-1); }
+		void sw(int value, int offset, int base){ emit(OP_SW,NO_REG,base,value,offset,-1); }
+		void hilo(Opcode op, int rs, int rt){ emit(op,NO_REG,rs,rt,0,-1); }
+		void mflo(int rd){ emit(OP_MFLO,rd,NO_REG,NO_REG,0,-1); }
+		void nop(){ emit(OP_NOP,NO_REG,NO_REG,NO_REG,0,-1); }
+		void branch(Opcode op, int rs, int rt, int label){ emit(op,NO_REG,rs,rt,0,label); }
+		void jump(int label){ emit(OP_B,NO_REG,NO_REG,NO_REG,0,label); }
+		void label(int label){ emit(OP_LABEL,NO_REG,NO_REG,NO_REG,0,label); }
+		void call(const std::string &function){ emit(OP_JAL,NO_REG,NO_REG,NO_REG,0,symbol(function)); }
+
+		void loadGlobal(int rd, const std::string &global){ // lui a,%hi(x) then lw rd,%lo(x)(a)
+			int sym = symbol(global);
+			int address = newReg(); // not rd, so if the peephole finds the value already in a register the lui goes too
+			emit(OP_LUI,address,NO_REG,NO_REG,0,sym);
+			emit(OP_LW,rd,address,NO_REG,0,sym);
+		}
+		void storeGlobal(int value, const std::string &global){
+			int sym = symbol(global);
+			int address = newReg();
+			emit(OP_LUI,address,NO_REG,NO_REG,0,sym);
+			emit(OP_SW,NO_REG,address,value,0,sym);
+		}
+};
+
+#endif
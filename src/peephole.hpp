@@ -0,0 +1,343 @@
+#ifndef peephole_hpp
+#define peephole_hpp
+
+#include <vector>
+#include <iostream>
+#include <climits>
+#include "mips.hpp"
+#include "trace.hpp"
+
+/* Peephole optimisation, run on a FunctionCode after the AST has been lowered and before registers are
+	allocated, so it sees every temporary as its own virtual register. The nodes compile one at a
+	time without looking at each other, which leaves plenty of these behind.
+
+	Each rule looks at one instruction (and maybe its neighbours) and rewrites it if it can. The
+	whole function is swept with every rule until a sweep changes nothing. Whether something is safe
+	mostly comes down to counting: how many times each virtual register is written and read in the
+	function. A temporary written once and read once can be renamed or folded into its only reader.
+
+	Removed instructions become nops for the rest of the sweep, and are taken out at the end.
+	--peephole-stats prints how many times each rule fired over the whole file, added up in the Session.
+*/
+
+class Peephole{
+	protected:
+		typedef bool (Peephole::*Apply)(size_t i);
+		struct Rule{
+			const char *name;
+			Apply apply;
+		};
+
+		static const int RULE_COUNT = 7;
+		static const Rule *rules(){
+			static const Rule table[RULE_COUNT] = {
+				{"dead-code",&Peephole::deadCode},
+				{"self-move",&Peephole::selfMove},
+				{"store-to-load",&Peephole::forwardLoad},
+				{"immediate-form",&Peephole::immediateForm},
+				{"fold-move",&Peephole::foldMove},
+				{"coalesce-move",&Peephole::coalesceMove},
+				{"propagate-copy",&Peephole::propagateCopy}
+			};
+			return table;
+		}
+
+		static const int FORWARD_WINDOW = 32; // how far back store-to-load looks for the last access
+
+		FunctionCode &code;
+		std::vector<MInstr> &in;
+		std::vector<unsigned long> fired; // per rule, in this function
+		std::vector<int> defs, uses; // per virtual register, over the whole function
+		std::vector<int> constDef; // index of the li that is a virtual register's only def, or -1
+
+		bool isVirtual(int reg) const { return reg>=FIRST_VREG; }
+		bool isTemporary(int reg) const { return isVirtual(reg) && !code.isVariable(reg); }
+
+		// keep the counts right as instructions change: forget the old form, change it, remember the new one
+		void forget(size_t i){
+			int u[2];
+			int n = in[i].uses(u);
+			for(int k=0; k<n; k++){
+				if(isVirtual(u[k])){
+					uses[u[k]-FIRST_VREG]--;
+				}
+			}
+			if(isVirtual(in[i].def())){
+				defs[in[i].def()-FIRST_VREG]--;
+				if(constDef[in[i].def()-FIRST_VREG]==(int)i){
+					constDef[in[i].def()-FIRST_VREG] = -1;
+				}
+			}
+		}
+		void remember(size_t i){
+			int u[2];
+			int n = in[i].uses(u);
+			for(int k=0; k<n; k++){
+				if(isVirtual(u[k])){
+					uses[u[k]-FIRST_VREG]++;
+				}
+			}
+			if(isVirtual(in[i].def())){
+				defs[in[i].def()-FIRST_VREG]++;
+			}
+		}
+		void remove(size_t i){
+			forget(i);
+			MInstr nop = {OP_NOP,NO_REG,NO_REG,NO_REG,0,-1};
+			in[i] = nop;
+		}
+
+		void count(){
+			int n = code.regCount()-FIRST_VREG;
+			defs.assign(n,0);
+			uses.assign(n,0);
+			constDef.assign(n,-1);
+			for(size_t i=0; i<in.size(); i++){
+				remember(i);
+			}
+			for(size_t i=0; i<in.size(); i++){
+				int d = in[i].def();
+				if(in[i].op==OP_LI && isVirtual(d) && defs[d-FIRST_VREG]==1){
+					constDef[d-FIRST_VREG] = i;
+				}
+			}
+		}
+
+		// the constant in reg, if it only ever holds one
+		bool constantIn(int reg, int &value) const {
+			if(!isVirtual(reg) || constDef[reg-FIRST_VREG]<0){
+				return false;
+			}
+			value = in[constDef[reg-FIRST_VREG]].imm;
+			return true;
+		}
+
+		// the next instruction after i that is not a removed one, or in.size()
+		size_t next(size_t i) const {
+			for(i++; i<in.size() && in[i].op==OP_NOP; i++){}
+			return i;
+		}
+
+		// nothing reads what this writes. Only for instructions that do nothing else
+		bool deadCode(size_t i){
+			int d = in[i].def();
+			if(!isVirtual(d) || uses[d-FIRST_VREG]>0){
+				return false;
+			}
+			remove(i);
+			return true;
+		}
+
+		bool selfMove(size_t i){
+			if(in[i].op!=OP_MOVE || in[i].rd!=in[i].rs){
+				return false;
+			}
+			remove(i);
+			return true;
+		}
+
+		// lw of a global whose value is already in a register, because it was just stored or loaded.
+		// There are no pointers, so only a store to the same global or a call can change it in between
+		bool forwardLoad(size_t i){
+			const MInstr &load = in[i];
+			if(load.op!=OP_LW || load.sym<0){
+				return false;
+			}
+			size_t limit = i>(size_t)FORWARD_WINDOW ? i-FORWARD_WINDOW : 0;
+			for(size_t j=i; j>limit; j--){
+				const MInstr &prev = in[j-1];
+				if(prev.op==OP_LABEL || prev.isBranch()){ // another way in, or a call
+					return false;
+				}
+				if((prev.op!=OP_SW && prev.op!=OP_LW) || prev.sym!=load.sym){
+					continue;
+				}
+				int value = prev.op==OP_SW ? prev.rt : prev.rd;
+				for(size_t k=j; k<i; k++){
+					if(in[k].def()==value){ // the register has moved on since
+						return false;
+					}
+				}
+				forget(i);
+				MInstr move = {OP_MOVE,load.rd,value,NO_REG,0,-1};
+				in[i] = move;
+				remember(i);
+				return true;
+			}
+			return false;
+		}
+
+		// li t,c then op d,s,t is op d,s,c with the immediate form, as long as c fits.
+		// t stays around while anything else reads it, and goes once dead-code finds it unused
+		bool immediateForm(size_t i){
+			MInstr &cur = in[i];
+			Opcode immOp;
+			bool commutes = false;
+			switch(cur.op){
+				case OP_ADDU: immOp = OP_ADDIU; commutes = true; break;
+				case OP_SUBU: immOp = OP_ADDIU; break;
+				case OP_AND: immOp = OP_ANDI; commutes = true; break;
+				case OP_OR: immOp = OP_ORI; commutes = true; break;
+				case OP_XOR: immOp = OP_XORI; commutes = true; break;
+				case OP_SLT: immOp = OP_SLTI; break;
+				case OP_SLTU: immOp = OP_SLTIU; break;
+				case OP_SLLV: immOp = OP_SLL; break;
+				case OP_SRAV: immOp = OP_SRA; break;
+				default: return false;
+			}
+			int src = cur.rs;
+			int c;
+			if(!constantIn(cur.rt,c)){
+				if(!commutes || !constantIn(cur.rs,c)){
+					return false;
+				}
+				src = cur.rt;
+			}
+			if(cur.op==OP_SUBU){
+				if(c==INT_MIN){
+					return false;
+				}
+				c = -c;
+			}
+			if(cur.op==OP_SLLV || cur.op==OP_SRAV){
+				c &= 31; // only the bottom 5 bits of the register count, same again for the immediate
+			}
+			else if(!fitsImmediate(immOp,c)){
+				return false;
+			}
+			forget(i);
+			MInstr imm = {immOp,cur.rd,src,NO_REG,c,-1};
+			cur = imm;
+			remember(i);
+			return true;
+		}
+
+		// move t,s then op t,t,x is op t,s,x. What the move put in t is gone once op writes it, so nothing
+		// else can read it, however many other times t is written. The front end does this for every
+		// variable read as an operand (a = a - 1 is move t,a; addiu t,t,-1; move a,t), and once folded
+		// t is written only once, so coalesce-move can take the last move as well
+		bool foldMove(size_t i){
+			const MInstr &move = in[i];
+			if(move.op!=OP_MOVE || !isVirtual(move.rd)){
+				return false;
+			}
+			size_t n = next(i);
+			if(n==in.size() || in[n].op==OP_LABEL || in[n].def()!=move.rd){
+				return false;
+			}
+			MInstr &user = in[n];
+			int u[2];
+			int count = user.uses(u);
+			if(!(count>0 && u[0]==move.rd) && !(count>1 && u[1]==move.rd)){
+				return false;
+			}
+			int t = move.rd;
+			int s = move.rs;
+			forget(n);
+			if(user.rs==t){
+				user.rs = s;
+			}
+			if(user.rt==t){
+				user.rt = s;
+			}
+			remember(n);
+			remove(i);
+			return true;
+		}
+
+		// op t,... then move d,t, where that is all t is for, is just op d,...
+		bool coalesceMove(size_t i){
+			const MInstr &move = in[i];
+			if(move.op!=OP_MOVE || !isTemporary(move.rs) || defs[move.rs-FIRST_VREG]!=1 || uses[move.rs-FIRST_VREG]!=1){
+				return false;
+			}
+			size_t p = i;
+			while(p>0 && in[p-1].op==OP_NOP){
+				p--;
+			}
+			if(p==0 || in[p-1].def()!=move.rs){
+				return false;
+			}
+			p--;
+			int d = move.rd;
+			forget(p);
+			in[p].rd = d;
+			remember(p);
+			remove(i);
+			return true;
+		}
+
+		// move t,s then something reading t, where that is all t is for, can read s itself
+		bool propagateCopy(size_t i){
+			const MInstr &move = in[i];
+			if(move.op!=OP_MOVE || !isTemporary(move.rd) || defs[move.rd-FIRST_VREG]!=1 || uses[move.rd-FIRST_VREG]!=1){
+				return false;
+			}
+			size_t n = next(i);
+			if(n==in.size() || in[n].op==OP_LABEL){
+				return false;
+			}
+			MInstr &user = in[n];
+			bool reads = false;
+			int u[2];
+			int count = user.uses(u);
+			for(int k=0; k<count; k++){
+				reads = reads || u[k]==move.rd;
+			}
+			if(!reads){
+				return false;
+			}
+			int t = move.rd;
+			int s = move.rs;
+			forget(n);
+			if(user.rs==t){
+				user.rs = s;
+			}
+			if(user.rt==t){
+				user.rt = s;
+			}
+			remember(n);
+			remove(i);
+			return true;
+		}
+
+	public:
+		Peephole(FunctionCode &_code) : code(_code), in(_code.instrs), fired(RULE_COUNT,0){}
+
+		void run(){
+			count();
+			bool changed = true;
+			while(changed){
+				changed = false;
+				for(size_t i=0; i<in.size(); i++){
+					for(int r=0; r<RULE_COUNT && in[i].op!=OP_NOP; r++){
+						if((this->*rules()[r].apply)(i)){
+							fired[r]++;
+							changed = true;
+						}
+					}
+				}
+			}
+			size_t kept = 0;
+			for(size_t i=0; i<in.size(); i++){
+				if(in[i].op!=OP_NOP){
+					in[kept++] = in[i];
+				}
+			}
+			TRACE(TRACE_CODEGEN, TRACE_INFO, code.name<<": peephole removed "<<in.size()-kept<<" instructions");
+			in.resize(kept);
+		}
+
+		// how many times each rule fired, to be added to the file's totals in the Session
+		const std::vector<unsigned long> &counts() const { return fired; }
+
+		static void report(std::ostream &dst, const std::vector<unsigned long> &hits){
+			dst<<"peephole:";
+			for(int r=0; r<RULE_COUNT; r++){
+				dst<<" "<<rules()[r].name<<" "<<(r<(int)hits.size() ? hits[r] : 0);
+			}
+			dst<<std::endl;
+		}
+};
+
+#endif
@@ -0,0 +1,459 @@
+#ifndef regalloc_hpp
+#define regalloc_hpp
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include <stdint.h>
+#include "mips.hpp"
+#include "cfg.hpp"
+#include "trace.hpp"
+
+/* Linear scan register allocation (Poletto and Sarkar), run once per function on its FunctionCode.
+
+	1. take the basic blocks from cfg.hpp and work out which virtual registers are live into
+		and out of each block, iterating until nothing changes so loops come out right
+	2. give every virtual register one interval covering everywhere it is live
+	3. walk the intervals in order of start, handing out physical registers and taking them back
+		when an interval ends. When there are none left, whichever interval ends furthest away goes
+		to the stack
+	4. rewrite the code with physical registers, loading and storing spilled registers through the
+		two scratch registers around each instruction that uses them
+	5. now the frame size is known, add the prologue and epilogue and save registers around calls
+
+	Around a call only the temporaries still live after it are saved, and anything live across a call
+	is steered into $16-23 to begin with so it needs no saving at all. A function that makes no calls
+	(a leaf) never touches $31 or the frame pointer, and if it needs no stack it gets no frame at all.
+
+	Register conventions
+	$0 - always 0
+	$2 - return value
+	$4-7 - argument registers
+	$8-15 - temporaries, given out by the allocator, saved by the caller around calls
+	$16-23 - saved registers, given out by the allocator, saved in the prologue if used
+	$24,25 - scratch for loading and storing spilled registers, never allocated
+	$29 - stack pointer
+	$30 - frame pointer
+	$31 - return address
+
+	Frame, from the frame pointer up
+	0-15		space for the arguments of functions we call
+	16-			spill slots
+	then		slots for saving temporaries around calls
+	then		saved registers $16-23 that we use
+	size-8		old frame pointer
+	size-4		return address
+
+	Leaf frame, from the stack pointer up
+	0-			spill slots
+	then		saved registers $16-23 that we use
+*/
+
+class RegSet{ // a bit set of virtual registers, numbered from 0
+	protected:
+		std::vector<uint64_t> words;
+	public:
+		RegSet(int size=0) : words((size+63)/64,0){}
+		void set(int i){ words[i>>6] |= (uint64_t)1<<(i&63); }
+		void clear(int i){ words[i>>6] &= ~((uint64_t)1<<(i&63)); }
+		bool test(int i) const { return (words[i>>6]>>(i&63)) & 1; }
+		bool unite(const RegSet &other){ // this |= other, returns true if that changed anything
+			bool changed = false;
+			for(size_t i=0; i<words.size(); i++){
+				uint64_t w = words[i] | other.words[i];
+				changed = changed || w!=words[i];
+				words[i] = w;
+			}
+			return changed;
+		}
+		void subtract(const RegSet &other){
+			for(size_t i=0; i<words.size(); i++){
+				words[i] &= ~other.words[i];
+			}
+		}
+		template<class F>
+		void each(F f) const { // calls f(i) for every member
+			for(size_t w=0; w<words.size(); w++){
+				uint64_t bits = words[w];
+				while(bits){
+					int b = __builtin_ctzll(bits);
+					f((int)(w*64+b));
+					bits &= bits-1;
+				}
+			}
+		}
+};
+
+class RegisterAllocator{
+	protected:
+		struct Liveness{ // for one block
+			RegSet use, def, liveIn, liveOut;
+		};
+		struct Interval{
+			int reg; // the virtual register
+			int start, end; // positions, 2*index for reads and 2*index+1 for writes
+			int phys; // physical register, or NO_REG if spilled
+			int slot; // spill slot, or -1
+		};
+
+		FunctionCode &code;
+		int nvregs;
+		ControlFlowGraph cfg;
+		std::vector<Liveness> flow; // flow[b] for block b of cfg
+		std::vector<Interval> intervals; // indexed by virtual register - FIRST_VREG
+		std::vector<int> hint; // hint[v] is a register v is copied from or to, worth sharing a physical register with
+		int spillSlots;
+		bool usedPhys[32];
+		std::vector<int> calls; // index of every jal
+		std::vector<std::vector<int> > callSaves; // for each jal in order, the temporaries live across it
+		bool leaf; // makes no calls
+		int base; // register the frame is addressed from, $fp or for leaves $sp
+
+		static const int SCRATCH1 = 24;
+		static const int SCRATCH2 = 25;
+
+		bool isVirtual(int reg) const { return reg>=FIRST_VREG; }
+
+		void findCalls(){
+			for(size_t i=0; i<code.instrs.size(); i++){
+				if(code.instrs[i].op==OP_JAL){
+					calls.push_back(i);
+				}
+			}
+			leaf = calls.empty();
+			base = leaf ? 29 : 30;
+		}
+
+		void liveness(){
+			flow.resize(cfg.size());
+			for(size_t b=0; b<cfg.size(); b++){
+				const BasicBlock &blk = cfg[b];
+				Liveness &lv = flow[b];
+				lv.use = RegSet(nvregs); lv.def = RegSet(nvregs);
+				lv.liveIn = RegSet(nvregs); lv.liveOut = RegSet(nvregs);
+				for(int i=blk.first; i<=blk.last; i++){
+					const MInstr &in = code.instrs[i];
+					int u[2];
+					int n = in.uses(u);
+					for(int k=0; k<n; k++){
+						if(isVirtual(u[k]) && !lv.def.test(u[k]-FIRST_VREG)){
+							lv.use.set(u[k]-FIRST_VREG);
+						}
+					}
+					if(isVirtual(in.def())){
+						lv.def.set(in.def()-FIRST_VREG);
+					}
+				}
+			}
+			bool changed = true;
+			while(changed){
+				changed = false;
+				for(size_t b=cfg.size(); b>0; b--){
+					const BasicBlock &blk = cfg[b-1];
+					Liveness &lv = flow[b-1];
+					for(size_t s=0; s<blk.succs.size(); s++){
+						lv.liveOut.unite(flow[blk.succs[s]].liveIn);
+					}
+					RegSet in = lv.liveOut;
+					in.subtract(lv.def);
+					in.unite(lv.use);
+					changed = lv.liveIn.unite(in) || changed;
+				}
+			}
+		}
+
+		void extend(int reg, int pos){
+			Interval &iv = intervals[reg-FIRST_VREG];
+			iv.start = std::min(iv.start,pos);
+			iv.end = std::max(iv.end,pos);
+		}
+
+		void buildIntervals(){
+			intervals.resize(nvregs);
+			hint.assign(code.regCount(),NO_REG);
+			for(int v=0; v<nvregs; v++){
+				Interval iv = {v+FIRST_VREG,INT_MAX,-1,NO_REG,-1};
+				intervals[v] = iv;
+			}
+			for(size_t b=0; b<cfg.size(); b++){
+				const BasicBlock &blk = cfg[b];
+				flow[b].liveIn.each([&](int v){ extend(v+FIRST_VREG,2*blk.first); });
+				flow[b].liveOut.each([&](int v){ extend(v+FIRST_VREG,2*blk.last+1); });
+				for(int i=blk.first; i<=blk.last; i++){
+					const MInstr &in = code.instrs[i];
+					int u[2];
+					int n = in.uses(u);
+					for(int k=0; k<n; k++){
+						if(isVirtual(u[k])){
+							extend(u[k],2*i);
+						}
+					}
+					if(isVirtual(in.def())){
+						extend(in.def(),2*i+1);
+					}
+					if(in.op==OP_MOVE && isVirtual(in.rd) && isVirtual(in.rs)){
+						hint[in.rd] = in.rs;
+						hint[in.rs] = in.rd;
+					}
+				}
+			}
+		}
+
+		// whether the interval is still needed after some call it was live before
+		bool crossesCall(const Interval &iv) const {
+			std::vector<int>::const_iterator c = std::lower_bound(calls.begin(),calls.end(),iv.start/2+1);
+			return c!=calls.end() && iv.end>=2*(*c)+1;
+		}
+
+		// order to try physical registers in. Saved registers cost a store and load in the prologue and epilogue,
+		// temporaries cost that around every call they are live across, so it depends which is more likely
+		static const int *preference(bool acrossCall){
+			static const int savedFirst[17] = {16,17,18,19,20,21,22,23,8,9,10,11,12,13,14,15,-1};
+			static const int tempsFirst[17] = {8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,-1};
+			return acrossCall ? savedFirst : tempsFirst;
+		}
+
+		void spill(Interval &iv){
+			iv.phys = NO_REG;
+			iv.slot = spillSlots++;
+			TRACE(TRACE_REGALLOC, TRACE_DEBUG, code.name<<": spilled $v"<<iv.reg-FIRST_VREG<<" to slot "<<iv.slot);
+		}
+
+		void linearScan(){
+			std::vector<Interval *> order;
+			for(size_t v=0; v<intervals.size(); v++){
+				if(intervals[v].end>=0){
+					order.push_back(&intervals[v]);
+				}
+			}
+			std::stable_sort(order.begin(),order.end(),[](const Interval *a, const Interval *b){ return a->start<b->start; });
+
+			bool free[32];
+			for(int r=0; r<32; r++){
+				free[r] = false;
+			}
+			for(int r=8; r<=23; r++){
+				free[r] = true;
+			}
+			std::vector<Interval *> active; // kept sorted by end
+
+			for(size_t i=0; i<order.size(); i++){
+				Interval *cur = order[i];
+				while(!active.empty() && active.front()->end<cur->start){ // expire anything finished before cur starts
+					free[active.front()->phys] = true;
+					active.erase(active.begin());
+				}
+
+				int phys = NO_REG;
+				int h = hint[cur->reg];
+				if(h!=NO_REG && intervals[h-FIRST_VREG].phys!=NO_REG && free[intervals[h-FIRST_VREG].phys]){
+					phys = intervals[h-FIRST_VREG].phys; // the move between them will disappear
+				}
+				for(const int *p = preference(crossesCall(*cur)); phys==NO_REG && *p>=0; p++){
+					if(free[*p]){
+						phys = *p;
+					}
+				}
+
+				if(phys==NO_REG){ // out of registers, spill whichever of cur and the active intervals ends last
+					Interval *last = active.back();
+					if(last->end>cur->end){
+						phys = last->phys;
+						spill(*last);
+						active.pop_back();
+					}
+					else{
+						spill(*cur);
+						continue;
+					}
+				}
+
+				cur->phys = phys;
+				free[phys] = false;
+				usedPhys[phys] = true;
+				std::vector<Interval *>::iterator pos = active.begin();
+				while(pos!=active.end() && (*pos)->end<=cur->end){
+					pos++;
+				}
+				active.insert(pos,cur);
+				TRACE(TRACE_REGALLOC, TRACE_NOISE, code.name<<": $v"<<cur->reg-FIRST_VREG<<(code.isVariable(cur->reg) ? " (variable)" : "")
+					<<" ["<<cur->start<<","<<cur->end<<"] -> $"<<phys);
+			}
+		}
+
+		// walks each block backwards from what is live out of it, to find what is live after each jal
+		void liveAtCalls(){
+			if(leaf){
+				return;
+			}
+			callSaves.resize(calls.size());
+			size_t next = calls.size(); // calls are met in reverse
+			for(size_t b=cfg.size(); b>0; b--){
+				const BasicBlock &blk = cfg[b-1];
+				RegSet live = flow[b-1].liveOut;
+				for(int i=blk.last; i>=blk.first; i--){
+					const MInstr &in = code.instrs[i];
+					if(in.op==OP_JAL){
+						next--;
+						std::vector<int> &saves = callSaves[next];
+						live.each([&](int v){
+							int phys = intervals[v].phys;
+							if(phys>=8 && phys<=15){
+								saves.push_back(phys);
+							}
+						});
+						std::sort(saves.begin(),saves.end());
+						continue;
+					}
+					if(isVirtual(in.def())){
+						live.clear(in.def()-FIRST_VREG);
+					}
+					int u[2];
+					int n = in.uses(u);
+					for(int k=0; k<n; k++){
+						if(isVirtual(u[k])){
+							live.set(u[k]-FIRST_VREG);
+						}
+					}
+				}
+			}
+		}
+
+		int spillOffset(int slot) const { return (leaf ? 0 : 16)+4*slot; }
+
+		void rewrite(){
+			std::vector<MInstr> out;
+			out.reserve(code.instrs.size());
+			for(size_t i=0; i<code.instrs.size(); i++){
+				MInstr in = code.instrs[i];
+				int *fields[3] = {&in.rd,&in.rs,&in.rt};
+				int d = in.def();
+				int loaded[2] = {NO_REG,NO_REG}; // spilled registers already loaded into SCRATCH1, SCRATCH2
+				int storeSlot = -1;
+				for(int f=0; f<3; f++){
+					int reg = *fields[f];
+					if(!isVirtual(reg)){
+						continue;
+					}
+					const Interval &iv = intervals[reg-FIRST_VREG];
+					if(iv.phys!=NO_REG){
+						*fields[f] = iv.phys;
+						continue;
+					}
+					if(f==0 && reg==d){ // written, goes through SCRATCH1 and is stored afterwards
+						*fields[f] = SCRATCH1;
+						storeSlot = iv.slot;
+						continue;
+					}
+					// read: load it, unless the other operand was the same register
+					int scratch = loaded[0]==reg ? SCRATCH1 : loaded[1]==reg ? SCRATCH2 : NO_REG;
+					if(scratch==NO_REG){
+						scratch = loaded[0]==NO_REG ? SCRATCH1 : SCRATCH2;
+						loaded[scratch==SCRATCH1 ? 0 : 1] = reg;
+						MInstr load = {OP_LW,scratch,base,NO_REG,spillOffset(iv.slot),-1};
+						out.push_back(load);
+					}
+					*fields[f] = scratch;
+				}
+				if(in.op!=OP_MOVE || in.rd!=in.rs){ // a move where both ends got the same register is left out, but not its store
+					out.push_back(in);
+				}
+				if(storeSlot>=0){
+					MInstr store = {OP_SW,NO_REG,base,SCRATCH1,spillOffset(storeSlot),-1};
+					out.push_back(store);
+				}
+			}
+			code.instrs.swap(out);
+		}
+
+		void lowerFrame(){
+			std::vector<int> calleeSaved;
+			for(int r=16; r<=23; r++){
+				if(usedPhys[r]){
+					calleeSaved.push_back(r);
+				}
+			}
+			size_t callSaveSlots = 0; // enough for the call with the most temporaries live across it
+			for(size_t c=0; c<callSaves.size(); c++){
+				callSaveSlots = std::max(callSaveSlots,callSaves[c].size());
+			}
+			int callSaveBase = spillOffset(spillSlots);
+			int calleeSaveBase = callSaveBase + 4*callSaveSlots;
+			int size = calleeSaveBase + 4*calleeSaved.size() + (leaf ? 0 : 8);
+			size = (size+7) & ~7;
+
+			std::vector<MInstr> out;
+			out.reserve(code.instrs.size()+16);
+			MInstr i;
+			if(size>0){
+				i = {OP_ADDIU,29,29,NO_REG,-size,-1}; out.push_back(i);
+			}
+			if(!leaf){
+				i = {OP_SW,NO_REG,29,31,size-4,-1}; out.push_back(i);
+				i = {OP_SW,NO_REG,29,30,size-8,-1}; out.push_back(i);
+			}
+			for(size_t k=0; k<calleeSaved.size(); k++){
+				i = {OP_SW,NO_REG,29,calleeSaved[k],calleeSaveBase+4*(int)k,-1}; out.push_back(i);
+			}
+			if(!leaf){
+				i = {OP_MOVE,30,29,NO_REG,0,-1}; out.push_back(i);
+			}
+
+			size_t call = 0;
+			unsigned long savedAroundCalls = 0;
+			for(size_t n=0; n<code.instrs.size(); n++){
+				const MInstr &in = code.instrs[n];
+				if(in.op==OP_JAL){ // keep the temporaries still needed afterwards safe from the callee
+					const std::vector<int> &saves = callSaves[call++];
+					for(size_t k=0; k<saves.size(); k++){
+						i = {OP_SW,NO_REG,30,saves[k],callSaveBase+4*(int)k,-1}; out.push_back(i);
+					}
+					out.push_back(in);
+					for(size_t k=0; k<saves.size(); k++){
+						i = {OP_LW,saves[k],30,NO_REG,callSaveBase+4*(int)k,-1}; out.push_back(i);
+					}
+					savedAroundCalls += saves.size();
+					continue;
+				}
+				out.push_back(in);
+				if(in.op==OP_LABEL && in.sym==code.returnLabel){
+					if(!leaf){ // $31 first, so it has arrived by the time jr needs it
+						i = {OP_MOVE,29,30,NO_REG,0,-1}; out.push_back(i);
+						i = {OP_LW,31,29,NO_REG,size-4,-1}; out.push_back(i);
+					}
+					for(size_t k=0; k<calleeSaved.size(); k++){
+						i = {OP_LW,calleeSaved[k],29,NO_REG,calleeSaveBase+4*(int)k,-1}; out.push_back(i);
+					}
+					if(!leaf){
+						i = {OP_LW,30,29,NO_REG,size-8,-1}; out.push_back(i);
+					}
+					if(size>0){
+						i = {OP_ADDIU,29,29,NO_REG,size,-1}; out.push_back(i);
+					}
+					i = {OP_JR,NO_REG,31,NO_REG,0,-1}; out.push_back(i);
+				}
+			}
+			code.instrs.swap(out);
+			TRACE(TRACE_REGALLOC, TRACE_INFO, code.name<<(leaf ? " (leaf)" : "")<<": "<<nvregs<<" virtual registers, "<<spillSlots<<" spilled, "
+				<<calleeSaved.size()<<" saved registers, "<<savedAroundCalls<<" saved around "<<calls.size()<<" calls, frame of "<<size<<" bytes");
+		}
+
+	public:
+		RegisterAllocator(FunctionCode &_code) : code(_code), nvregs(_code.regCount()-FIRST_VREG), cfg(_code), spillSlots(0), leaf(true), base(30){
+			for(int r=0; r<32; r++){
+				usedPhys[r] = false;
+			}
+		}
+
+		void run(){
+			findCalls();
+			liveness();
+			buildIntervals();
+			linearScan();
+			liveAtCalls();
+			rewrite();
+			lowerFrame();
+		}
+};
+
+#endif
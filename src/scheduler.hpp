@@ -0,0 +1,211 @@
+#ifndef scheduler_hpp
+#define scheduler_hpp
+
+#include <vector>
+#include "mips.hpp"
+#include "trace.hpp"
+
+/* Runs on a FunctionCode after register allocation, and is the last thing before printing.
+	Functions are printed inside .set noreorder, so the assembler takes the code exactly as written
+	and everything here is our job:
+
+	- every branch, jump and call has a delay slot. Fill it with an instruction from just before the
+		branch that nothing in between depends on, otherwise with a nop
+	- MIPS I hazards. The instruction after a lw may not read the register being loaded, and mult or
+		div may not start within two instructions of a mflo. Only there do we put nops
+
+	Loads and mflo are never moved into a delay slot. The instruction after a delay slot can be the
+	first instruction at the branch target, which we cannot see from here, so keeping loads and mflo
+	out of delay slots means each hazard only ever has to be checked against the instructions before
+	it in the listing. Before any of that, branches to the label straight after them are dropped.
+*/
+
+class Scheduler{
+	protected:
+		FunctionCode &code;
+		std::vector<MInstr> out;
+		unsigned long filled, empty, hazardNops, dropped;
+
+		static const int LOOKBACK = 8; // how far back to look for something to put in a delay slot
+
+		static bool reads(const MInstr &in, int reg){
+			if(reg==NO_REG || reg==0){
+				return false;
+			}
+			int u[2];
+			int n = in.uses(u);
+			for(int k=0; k<n; k++){
+				if(u[k]==reg){
+					return true;
+				}
+			}
+			return in.op==OP_JAL && reg>=4 && reg<=7; // arguments, if we ever pass any
+		}
+		static bool writes(const MInstr &in, int reg){
+			if(reg==NO_REG){
+				return false;
+			}
+			return in.def()==reg || (in.op==OP_JAL && reg==31);
+		}
+		static bool touchesMemory(const MInstr &in){
+			return in.op==OP_LW || in.op==OP_SW || in.op==OP_JAL;
+		}
+		static bool usesHiLo(const MInstr &in){
+			return in.op==OP_MULT || in.op==OP_DIV || in.op==OP_MFLO;
+		}
+		static bool isNop(const MInstr &in){
+			return in.op==OP_NOP;
+		}
+		static MInstr nop(){
+			MInstr i = {OP_NOP,NO_REG,NO_REG,NO_REG,0,-1};
+			return i;
+		}
+
+		// a li that does not fit in 16 bits is two instructions, which cannot share one delay slot
+		static bool singleInstruction(const MInstr &in){
+			return in.op!=OP_LI || (in.imm>=-32768 && in.imm<=65535);
+		}
+
+		// whether x could move from out[j] to just after branch, past out[j+1..end)
+		bool canMove(size_t j, const MInstr &branch) const {
+			const MInstr &x = out[j];
+			if(x.op==OP_LABEL || x.isBranch() || isNop(x) || x.op==OP_LW || usesHiLo(x) || !singleInstruction(x)){
+				return false;
+			}
+			int u[2];
+			int n = x.uses(u);
+			int d = x.def();
+			if(writes(branch,d) || reads(branch,d)){ // the branch needs the old value, or clobbers the new one
+				return false;
+			}
+			for(int k=0; k<n; k++){
+				if(writes(branch,u[k])){
+					return false;
+				}
+			}
+			for(size_t m=j+1; m<out.size(); m++){
+				const MInstr &y = out[m];
+				if(reads(y,d) || writes(y,d)){
+					return false;
+				}
+				for(int k=0; k<n; k++){
+					if(writes(y,u[k])){
+						return false;
+					}
+				}
+				if(x.op==OP_SW && touchesMemory(y)){
+					return false;
+				}
+			}
+			// taking x out must not leave a load right before something that reads what it loaded
+			if(j>0 && out[j-1].op==OP_LW){
+				const MInstr &next = j+1<out.size() ? out[j+1] : branch;
+				if(reads(next,out[j-1].def())){
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void placeBranch(const MInstr &branch){
+			size_t limit = out.size()>(size_t)LOOKBACK ? out.size()-LOOKBACK : 0;
+			for(size_t j=out.size(); j>limit; j--){
+				const MInstr &x = out[j-1];
+				if(x.op==OP_LABEL || x.isBranch() || (j>=2 && out[j-2].isBranch())){ // start of the block, or a delay slot
+					break;
+				}
+				if(canMove(j-1,branch)){
+					MInstr moved = x;
+					out.erase(out.begin()+(j-1));
+					out.push_back(branch);
+					out.push_back(moved);
+					filled++;
+					return;
+				}
+			}
+			out.push_back(branch);
+			out.push_back(nop());
+			empty++;
+		}
+
+		// a branch to one of the labels straight after it goes nowhere. Conditional ones only read registers, so they can go too
+		bool toNextLabel(size_t i) const {
+			const MInstr &branch = code.instrs[i];
+			if(branch.op!=OP_B && branch.op!=OP_BEQ && branch.op!=OP_BNE){
+				return false;
+			}
+			for(size_t k=i+1; k<code.instrs.size() && code.instrs[k].op==OP_LABEL; k++){
+				if(code.instrs[k].sym==branch.sym){
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// puts nops in front of anything that would hit a hazard. Labels are skipped over when looking back
+		void fixHazards(){
+			std::vector<MInstr> in;
+			in.swap(out);
+			const MInstr *last1 = NULL; // the previous two real instructions
+			const MInstr *last2 = NULL;
+			MInstr filler = nop();
+			for(size_t i=0; i<in.size(); i++){
+				const MInstr &cur = in[i];
+				if(cur.op==OP_LABEL){
+					out.push_back(cur);
+					continue;
+				}
+				int needed = 0;
+				if(last1!=NULL && last1->op==OP_LW && reads(cur,last1->def())){
+					needed = 1;
+				}
+				if(cur.op==OP_MULT || cur.op==OP_DIV){
+					if(last1!=NULL && last1->op==OP_MFLO){
+						needed = 2;
+					}
+					else if(last2!=NULL && last2->op==OP_MFLO && needed<1){
+						needed = 1;
+					}
+				}
+				for(int k=0; k<needed; k++){
+					out.push_back(filler);
+					hazardNops++;
+				}
+				if(needed>0){
+					last2 = needed>1 ? &filler : last1;
+					last1 = &filler;
+				}
+				out.push_back(cur);
+				last2 = last1;
+				last1 = &in[i];
+			}
+		}
+
+	public:
+		Scheduler(FunctionCode &_code) : code(_code), filled(0), empty(0), hazardNops(0), dropped(0){}
+
+		void run(){
+			out.reserve(code.instrs.size()+code.instrs.size()/4);
+			for(size_t i=0; i<code.instrs.size(); i++){
+				const MInstr &in = code.instrs[i];
+				if(isNop(in)){ // anything still asking for a nop gets one from fixHazards if it is really needed
+					continue;
+				}
+				if(toNextLabel(i)){
+					dropped++;
+					continue;
+				}
+				if(in.isBranch()){
+					placeBranch(in);
+				}
+				else{
+					out.push_back(in);
+				}
+			}
+			fixHazards();
+			code.instrs.swap(out);
+			TRACE(TRACE_CODEGEN, TRACE_INFO, code.name<<": filled "<<filled<<" of "<<filled+empty<<" delay slots, "<<hazardNops<<" nops for hazards, "<<dropped<<" branches to the next label dropped");
+		}
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef session_hpp
+#define session_hpp
+
+#include <vector>
+#include <mutex>
+#include <string>
+#include <iostream>
+#include "arena.hpp"
+#include "symbols.hpp"
+#include "timer.hpp"
+
+class Node;
+class FunctionIndex;
+
+/* Everything that belongs to one translation unit, from lexing to the last line of output. This
+	used to be globals: yyin and yylval in the lexer, g_root, g_arena and g_interner in the parser,
+	and the global variable list as a static in ast_node.hpp (one copy per .cpp file that included
+	it). Now the scanner and parser are reentrant and get the session passed in, and codegen reaches
+	it through the Context, so two files can be compiled in one process, or at once. Label numbers
+	are per function, in FunctionCode.
+
+	Functions of one file can be compiled on several threads (see Program::compile), so the little
+	codegen writes to in here is behind a lock.
+
+	The arena and interner are only borrowed, so they can be kept and reused from one file to the next.
+*/
+
+class Session{
+	protected:
+		std::mutex lock;
+
+	public:
+		Arena &arena; // every node and token string, see parseAST
+		Interner &interner; // identifiers to symbols
+		const Node *root; // the top of the tree once parsed, NULL until then
+		const char *text; // the source, set by parseAST. Only there until the file is compiled, NULL when it is gone
+		FunctionIndex *index; // --incremental, what each function compiled to last time. NULL if not used
+		TimeReport *times; // --time-report, this file's phases. NULL if not used
+		std::vector<Symbol> globals; // every global in the file, for the python translation
+		std::vector<unsigned long> peepholeHits; // per peephole rule, for --peephole-stats
+		size_t threads; // how many functions to compile at once
+		unsigned errors; // found while compiling, see error. Any at all and the file has failed
+
+		Session(Arena &_arena, Interner &_interner) : arena(_arena), interner(_interner), root(NULL), text(NULL), index(NULL), times(NULL), threads(1), errors(0){}
+
+		// something in the source that cannot be compiled. Always printed, whatever the trace level
+		void error(const std::string &message){
+			std::lock_guard<std::mutex> hold(lock);
+			std::cerr<<"Error: "<<message<<std::endl;
+			errors++;
+		}
+
+		void countPeephole(const std::vector<unsigned long> &fired){ // one function's worth
+			std::lock_guard<std::mutex> hold(lock);
+			peepholeHits.resize(fired.size(),0);
+			for(size_t r=0; r<fired.size(); r++){
+				peepholeHits[r] += fired[r];
+			}
+		}
+};
+
+#endif
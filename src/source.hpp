@@ -0,0 +1,80 @@
+#ifndef source_hpp
+#define source_hpp
+
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+/* The whole of a source file in one block of memory, for the lexer to scan in place with
+	yy_scan_buffer instead of reading it a few kB at a time through yyin. flex wants the last two
+	bytes to be 0, so they are added on the end and counted in size(), but are not part of the text.
+
+	A file is read with a single fread, since its size is known up front. stdin (no file, or "-")
+	cannot be measured, so that is read in doubling chunks into the same buffer.
+*/
+
+// a run of bytes in the source, from begin up to but not including end. The parser's locations are these
+struct SourceSpan{
+	size_t begin, end;
+};
+
+class SourceBuffer{
+	protected:
+		std::vector<char> buf;
+		size_t length; // of the text, without the two zeros
+
+		bool readAll(FILE *in){ // for streams of unknown size
+			size_t chunk = 1<<16;
+			while(true){
+				buf.resize(length+chunk);
+				size_t n = std::fread(&buf[length],1,chunk,in);
+				length += n;
+				if(n<chunk){
+					return !std::ferror(in);
+				}
+				chunk *= 2;
+			}
+		}
+
+	public:
+		SourceBuffer() : length(0){}
+
+		// false if the file could not be opened or read
+		bool load(const char *location){
+			length = 0;
+			bool ok;
+			if(location==NULL || std::strcmp(location,"-")==0){
+				ok = readAll(stdin);
+			}
+			else{
+				FILE *in = std::fopen(location,"rb");
+				if(in==NULL){
+					return false;
+				}
+				long size = -1;
+				if(std::fseek(in,0,SEEK_END)==0){
+					size = std::ftell(in);
+					std::rewind(in);
+				}
+				if(size>=0){
+					buf.resize(size+2);
+					length = std::fread(&buf[0],1,size,in);
+					ok = length==(size_t)size;
+				}
+				else{ // a pipe or something else that cannot seek
+					ok = readAll(in);
+				}
+				std::fclose(in);
+			}
+			buf.resize(length+2);
+			buf[length] = 0;
+			buf[length+1] = 0;
+			return ok;
+		}
+
+		char *data(){ return &buf[0]; }
+		size_t size() const { return length+2; } // what yy_scan_buffer is given
+		size_t textSize() const { return length; }
+};
+
+#endif
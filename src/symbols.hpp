@@ -0,0 +1,45 @@
+#ifndef symbols_hpp
+#define symbols_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* String interning. The lexer turns every identifier into a Symbol, which carries a small dense
+	integer id (0,1,2... in order of first appearance) and a pointer to the one shared copy of the
+	name. The id is what Context indexes its table with, the name is only needed when printing.
+*/
+
+typedef int SymId;
+
+struct Symbol{ // plain data so that it can sit in the bison %union
+	SymId id;
+	const std::string *text;
+
+	const std::string &name() const { return *text; }
+};
+
+class Interner{
+	protected:
+		std::unordered_map<std::string, SymId> ids; // nodes in an unordered_map never move, so pointers to the keys stay valid
+		std::vector<const std::string *> names; // names[id]
+
+	public:
+		Symbol intern(const std::string &name){
+			std::unordered_map<std::string, SymId>::iterator pos = ids.find(name);
+			if(pos==ids.end()){
+				pos = ids.insert(std::make_pair(name,(SymId)names.size())).first;
+				names.push_back(&pos->first);
+			}
+			Symbol s;
+			s.id = pos->second;
+			s.text = &pos->first;
+			return s;
+		}
+
+		const std::string &name(SymId id) const { return *names[id]; }
+
+		size_t size() const { return names.size(); } // ids run from 0 to size()-1
+};
+
+#endif
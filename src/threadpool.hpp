@@ -0,0 +1,82 @@
+#ifndef threadpool_hpp
+#define threadpool_hpp
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <memory>
+
+/* A fixed set of worker threads for -j, sharing out a known number of tasks (numbered 0 to count-1,
+	one per source file). Each worker has its own queue, dealt out round robin to start with. It takes
+	from the front of its own, and once that is empty steals from the back of the others, so one big
+	file does not hold up the small ones queued behind it. No task makes more, so a worker that finds
+	every queue empty is done.
+
+	Which worker runs a task is passed to the job, so it can use that worker's own arena and so on.
+	The calling thread is worker 0.
+*/
+
+class WorkStealingPool{
+	protected:
+		struct Queue{
+			std::mutex lock;
+			std::deque<size_t> tasks;
+		};
+		std::vector<std::unique_ptr<Queue>> queues; // one per worker
+
+		bool take(size_t worker, size_t &task){
+			for(size_t k=0; k<queues.size(); k++){ // its own first, then the others in turn
+				Queue &q = *queues[(worker+k)%queues.size()];
+				std::lock_guard<std::mutex> hold(q.lock);
+				if(q.tasks.empty()){
+					continue;
+				}
+				if(k==0){
+					task = q.tasks.front();
+					q.tasks.pop_front();
+				}
+				else{
+					task = q.tasks.back();
+					q.tasks.pop_back();
+				}
+				return true;
+			}
+			return false;
+		}
+
+		template<class Job>
+		void work(size_t worker, Job &job){
+			size_t task;
+			while(take(worker,task)){
+				job(worker,task);
+			}
+		}
+
+	public:
+		WorkStealingPool(size_t workers){
+			for(size_t w=0; w<(workers ? workers : 1); w++){
+				queues.push_back(std::unique_ptr<Queue>(new Queue));
+			}
+		}
+
+		size_t size() const { return queues.size(); }
+
+		// calls job(worker,task) once for every task, returns when they have all finished
+		template<class Job>
+		void run(size_t count, Job job){
+			for(size_t t=0; t<count; t++){
+				queues[t%queues.size()]->tasks.push_back(t);
+			}
+			std::vector<std::thread> threads;
+			for(size_t w=1; w<queues.size(); w++){
+				threads.push_back(std::thread([this,w,&job](){ work(w,job); }));
+			}
+			work(0,job);
+			for(size_t i=0; i<threads.size(); i++){
+				threads[i].join();
+			}
+		}
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef timer_hpp
+#define timer_hpp
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+/* --time-report: where the time goes, phase by phase, on the monotonic clock.
+
+	Each phase is only the time spent in it and not in another one, so they add up. Lexing happens
+	inside yyparse, one token at a time, and exploring inside the parser actions that make functions,
+	so parse is what is left of yyparse once those two are taken out (see parseAST). Codegen is the
+	nodes building a function's instructions (or translating to python), passes is the peephole
+	optimiser, register allocation and scheduling, and output is printing and writing it out.
+
+	A Session has its own report while its file is compiled, merged into the one for the whole run at
+	the end. Functions compiled at once (-j) all add to the same phases, so with more than one thread
+	the phases can add up to more than the time it took.
+
+	Nothing is timed unless Session::times is set, and a PhaseTimer with no report does nothing.
+*/
+
+enum Phase{
+	PHASE_LEX,
+	PHASE_PARSE,
+	PHASE_EXPLORE,
+	PHASE_CODEGEN,
+	PHASE_PASSES,
+	PHASE_OUTPUT,
+	PHASE_COUNT
+};
+
+enum Tally{ // things counted alongside the times
+	TALLY_FILES,
+	TALLY_TOKENS,
+	TALLY_NODES, // everything the parser put in the arena, nodes and the strings in them
+	TALLY_FUNCTIONS,
+	TALLY_INSTRUCTIONS, // after the passes, so what is printed
+	TALLY_COUNT
+};
+
+class TimeReport{
+	protected:
+		std::atomic<unsigned long long> nanos[PHASE_COUNT];
+		std::atomic<unsigned long long> tallies[TALLY_COUNT];
+
+		static const char *phaseName(int p){
+			static const char *names[PHASE_COUNT] = {"lex","parse","explore","codegen","passes","output"};
+			return names[p];
+		}
+		static const char *tallyName(int t){
+			static const char *names[TALLY_COUNT] = {"files","tokens","nodes","functions","instructions"};
+			return names[t];
+		}
+
+	public:
+		TimeReport(){
+			for(int p=0; p<PHASE_COUNT; p++){
+				nanos[p] = 0;
+			}
+			for(int t=0; t<TALLY_COUNT; t++){
+				tallies[t] = 0;
+			}
+		}
+		TimeReport(const TimeReport &) = delete;
+		TimeReport &operator=(const TimeReport &) = delete;
+
+		static unsigned long long now(){
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void add(Phase p, unsigned long long ns){ nanos[p] += ns; }
+		void count(Tally t, unsigned long long n){ tallies[t] += n; }
+		unsigned long long time(Phase p) const { return nanos[p]; }
+		unsigned long long tally(Tally t) const { return tallies[t]; }
+
+		void merge(const TimeReport &other){
+			for(int p=0; p<PHASE_COUNT; p++){
+				nanos[p] += other.nanos[p];
+			}
+			for(int t=0; t<TALLY_COUNT; t++){
+				tallies[t] += other.tallies[t];
+			}
+		}
+
+		// like gcc's -ftime-report, a line per phase. wall is how long the whole run took, in ns
+		void print(std::ostream &dst, unsigned long long wall) const {
+			unsigned long long total = 0;
+			for(int p=0; p<PHASE_COUNT; p++){
+				total += nanos[p];
+			}
+			std::ios::fmtflags flags = dst.flags();
+			std::streamsize precision = dst.precision();
+			dst<<std::fixed<<std::setprecision(3);
+			dst<<"Execution times (seconds)"<<std::endl;
+			for(int p=0; p<PHASE_COUNT; p++){
+				dst<<"  "<<std::left<<std::setw(10)<<phaseName(p)<<std::right<<":"<<std::setw(10)<<nanos[p]/1e9
+					<<" ("<<std::setw(5)<<std::setprecision(1)<<(total ? 100.0*nanos[p]/total : 0.0)<<"%)"<<std::setprecision(3)<<std::endl;
+			}
+			dst<<"  "<<std::left<<std::setw(10)<<"TOTAL"<<std::right<<":"<<std::setw(10)<<total/1e9<<std::endl;
+			dst<<"  "<<std::left<<std::setw(10)<<"wall"<<std::right<<":"<<std::setw(10)<<wall/1e9<<std::endl;
+			for(int t=0; t<TALLY_COUNT; t++){
+				dst<<"  "<<std::left<<std::setw(13)<<tallyName(t)<<std::right<<std::setw(10)<<tallies[t];
+				if(t==TALLY_TOKENS && nanos[PHASE_LEX]+nanos[PHASE_PARSE]){
+					dst<<" ("<<std::setprecision(0)<<tallies[t]*1e9/(nanos[PHASE_LEX]+nanos[PHASE_PARSE])<<" per second lexed and parsed)";
+				}
+				dst<<std::endl;
+			}
+			dst.flags(flags);
+			dst.precision(precision);
+		}
+
+		// the same as one line of JSON, times in nanoseconds
+		void printJSON(std::ostream &dst, unsigned long long wall) const {
+			dst<<"{\"phases_ns\":{";
+			for(int p=0; p<PHASE_COUNT; p++){
+				dst<<(p ? "," : "")<<"\""<<phaseName(p)<<"\":"<<nanos[p];
+			}
+			dst<<"},\"wall_ns\":"<<wall<<",\"counts\":{";
+			for(int t=0; t<TALLY_COUNT; t++){
+				dst<<(t ? "," : "")<<"\""<<tallyName(t)<<"\":"<<tallies[t];
+			}
+			dst<<"}}"<<std::endl;
+		}
+};
+
+// adds the time from when it is made to when it goes out of scope to one phase
+class PhaseTimer{
+	protected:
+		TimeReport *report;
+		Phase phase;
+		unsigned long long start;
+
+	public:
+		PhaseTimer(TimeReport *_report, Phase _phase) : report(_report), phase(_phase), start(_report ? TimeReport::now() : 0){}
+		PhaseTimer(const PhaseTimer &) = delete;
+		~PhaseTimer(){
+			if(report!=NULL){
+				report->add(phase,TimeReport::now()-start);
+			}
+		}
+};
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef trace_hpp
+#define trace_hpp
+
+#include <iostream>
+#include <string>
+#include <sstream>
+
+/* Debug tracing. This replaces the std::cerr chatter that used to be spread over every node.
+
+	Tracing is compiled in when COMPILER_TRACE is non zero (the makefile sets it, "make TRACE=0"
+	strips it). When compiled out the TRACE macro expands to nothing, so the messages are never
+	even formatted. When compiled in, nothing is printed unless it was turned on at run time with
+	-v (more v's for more detail) or --trace=category[,category] on the command line.
+*/
+
+#ifndef COMPILER_TRACE
+#define COMPILER_TRACE 1
+#endif
+
+enum TraceCategory{ // one bit each so they can be combined
+	TRACE_LEXER = 1,
+	TRACE_PARSER = 2,
+	TRACE_EXPLORE = 4,
+	TRACE_CODEGEN = 8,
+	TRACE_REGALLOC = 16,
+	TRACE_TRANSLATE = 32,
+	TRACE_ALL = 63
+};
+
+enum TraceLevel{
+	TRACE_INFO = 1, // a line or two per function
+	TRACE_DEBUG = 2, // a line or two per node
+	TRACE_NOISE = 3 // everything, including per token output
+};
+
+class Trace{
+	protected:
+		unsigned categories; // which categories are switched on
+		int level; // 0 means tracing is off
+
+		Trace() : categories(0), level(0){}
+
+	public:
+		static Trace &get(){ // there is only ever one, shared by the lexer, parser and every node
+			static Trace instance;
+			return instance;
+		}
+
+		bool on(unsigned category, int lvl) const {
+			return (categories & category) && lvl <= level;
+		}
+
+		static const char *name(unsigned category){
+			switch(category){
+				case TRACE_LEXER: return "lexer";
+				case TRACE_PARSER: return "parser";
+				case TRACE_EXPLORE: return "explore";
+				case TRACE_CODEGEN: return "codegen";
+				case TRACE_REGALLOC: return "regalloc";
+				case TRACE_TRANSLATE: return "translate";
+				default: return "all";
+			}
+		}
+
+		// takes a comma separated list such as "codegen,regalloc". Returns false if a name is not recognised
+		bool parseCategories(const std::string &list, unsigned &out) const {
+			std::stringstream ss(list);
+			std::string item;
+			while(std::getline(ss,item,',')){
+				bool found=false;
+				for(unsigned c=TRACE_LEXER; c<=TRACE_TRANSLATE; c<<=1){
+					if(item==name(c)){
+						out|=c;
+						found=true;
+					}
+				}
+				if(item=="all"){
+					out|=TRACE_ALL;
+					found=true;
+				}
+				if(!found){
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/* verbosity is the number of -v flags seen, selected is the categories asked for with --trace.
+			-v on its own traces everything, --trace on its own traces those categories in full */
+		void configure(int verbosity, unsigned selected){
+			categories = selected ? selected : (verbosity ? (unsigned)TRACE_ALL : 0u);
+			level = verbosity ? verbosity : (selected ? (int)TRACE_NOISE : 0);
+		}
+};
+
+// TRACE_ON is for guarding anything more than a single message, eg Context::dumpTable
+#if COMPILER_TRACE
+#define TRACE_ON(category, lvl) (Trace::get().on((category),(lvl)))
+#define TRACE(category, lvl, msg) \
+	do{ \
+		if(Trace::get().on((category),(lvl))){ \
+			std::cerr<<"["<<Trace::name(category)<<"] "<<msg<<std::endl; \
+		} \
+	}while(0)
+#else
+#define TRACE_ON(category, lvl) (false)
+#define TRACE(category, lvl, msg) do{}while(0)
+#endif
+
+#endif
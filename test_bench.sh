@@ -8,9 +8,9 @@ fi
 
 mkdir -p working
 
-for DRIVER in test_deliverable/testcases/*_driver.c ; do
+for DRIVER in test_deliverable/test_cases/*_driver.c ; do
     NAME=$(basename $DRIVER _driver.c)
-    TESTCODE=test_deliverable/testcases/$NAME.c
+    TESTCODE=test_deliverable/test_cases/$NAME.c
     
     >&2 echo "Test case $NAME"
     
@@ -37,8 +37,10 @@ for DRIVER in test_deliverable/testcases/*_driver.c ; do
     
     # Run the actual executable
     qemu-mips working/${NAME}.elf
-    if [[ $? -ne 0 ]]; then
-        >&2 echo "ERROR : Testcase returned $?, but expected 0."
+    RESULT=$?
+    if [[ ${RESULT} -ne 0 ]]; then
+        >&2 echo "ERROR : Testcase returned ${RESULT}, but expected 0."
+        continue
     fi
 
     echo "pass"
@@ -0,0 +1,49 @@
+/* .set noreorder: every delay slot, load delay and mflo / mult gap in here is the compiler's own doing */
+
+int loop(){
+	int i = 0;
+	int sum = 0;
+	while(i < 10){
+		sum = sum + i;
+		i = i + 1;
+	}
+	return sum; /* 45 */
+}
+
+int choose(){
+	int x = 7;
+	int y = 0;
+	if(x > 5){
+		y = x + 1;
+	}
+	else{
+		y = x - 1;
+	}
+	if(x < 5){
+		y = y + 100;
+	}
+	else{
+		y = y * 2;
+	}
+	return y; /* 16 */
+}
+
+int three(){
+	return 3;
+}
+
+int call(){
+	int x = three() + 1; /* $2 read straight after the jal and its delay slot */
+	if(three() == 3){
+		x = x * three();
+	}
+	return x; /* 12 */
+}
+
+int muldiv(){
+	int a = 123;
+	int b = 7;
+	int p = a * b; /* 861, mflo straight after mult */
+	int q = p / b; /* 123, and a div right after that mflo */
+	return (p / 3) * (q * b) - p * q; /* 287*861 - 861*123 = 141204 */
+}
@@ -0,0 +1,10 @@
+/*driver for test case delay_slots: a loop, an if / else, a call whose result is used at once, and mult / div then mflo*/
+
+int loop();
+int choose();
+int call();
+int muldiv();
+
+int main(){
+	return loop()!=45 || choose()!=16 || call()!=12 || muldiv()!=141204; /* 0 if all of them are right */
+}
@@ -0,0 +1,95 @@
+/* constant folding and division by powers of 2 at the edges. Each case is done on constants, which get folded, and on variables, which do not */
+
+int addFolded(){
+	return 2147483647 + 1; /* wraps to -2147483648 */
+}
+
+int addRun(){
+	int m = 2147483647;
+	return m + 1;
+}
+
+int subFolded(){
+	return -2147483648 - 1; /* wraps to 2147483647 */
+}
+
+int subRun(){
+	int m = -2147483648;
+	return m - 1;
+}
+
+int mulFolded(){
+	return 46341 * 46341; /* 2147488281 wraps to -2147479015 */
+}
+
+int mulRun(){
+	int a = 46341;
+	return a * a;
+}
+
+int minDivFolded(){
+	return -2147483648 / -1; /* overflows. Not folded, div gives -2147483648 */
+}
+
+int minDivRun(){
+	int m = -2147483648;
+	int d = -1;
+	return m / d;
+}
+
+int divFolded(){
+	return -7 / 2; /* -3, division rounds towards 0 */
+}
+
+int divRun(){
+	int a = -7;
+	int b = -1;
+	int c = -9;
+	int d = -65537;
+	int e = -2147483648;
+	int f = 7;
+	if(a / 2 != -3){
+		return 1;
+	}
+	if(b / 4 != 0){
+		return 2;
+	}
+	if(c / 8 != -1){
+		return 3;
+	}
+	if(d / 65536 != -1){
+		return 4;
+	}
+	if(e / 2 != -1073741824){
+		return 5;
+	}
+	if(f / 2 != 3){
+		return 6;
+	}
+	return 0;
+}
+
+int shiftFolded(){
+	return (1 << 31) + (-1 >> 31) + (-64 >> 3); /* -2147483648 - 1 - 8 = 2147483639 */
+}
+
+int shiftRun(){
+	int x = 5;
+	int y = -64;
+	int n32 = 32;
+	int n33 = 33;
+	int n35 = 35;
+	if(x << n32 != 5){ /* sllv and srav only use the bottom 5 bits of the count, as gcc's code does */
+		return 1;
+	}
+	if(x << n33 != 10){
+		return 2;
+	}
+	if(y >> n35 != -8){
+		return 3;
+	}
+	if(y >> n32 != -64){
+		return 4;
+	}
+	return 0;
+}
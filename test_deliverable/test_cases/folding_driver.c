@@ -0,0 +1,42 @@
+/*driver for test case folding: the folded and unfolded versions of each case should agree, and match gcc*/
+
+int addFolded();
+int addRun();
+int subFolded();
+int subRun();
+int mulFolded();
+int mulRun();
+int minDivFolded();
+int minDivRun();
+int divFolded();
+int divRun();
+int shiftFolded();
+int shiftRun();
+
+int main(){
+	if(addFolded()!=-2147483647-1 || addRun()!=-2147483647-1){
+		return 1;
+	}
+	if(subFolded()!=2147483647 || subRun()!=2147483647){
+		return 2;
+	}
+	if(mulFolded()!=-2147479015 || mulRun()!=-2147479015){
+		return 3;
+	}
+	if(minDivFolded()!=-2147483647-1 || minDivRun()!=-2147483647-1){
+		return 4;
+	}
+	if(divFolded()!=-3){
+		return 5;
+	}
+	if(divRun()!=0){
+		return 6;
+	}
+	if(shiftFolded()!=2147483639){
+		return 7;
+	}
+	if(shiftRun()!=0){
+		return 8;
+	}
+	return 0;
+}
@@ -0,0 +1,55 @@
+/* constants at the edges of the immediate fields. addiu and slti sign extend theirs, andi, ori and xori zero extend them */
+
+int x;
+int r1;
+int r2;
+int r3;
+int r4;
+
+int addImm(){
+	r1 = x + -32768;
+	r2 = x + 32767;
+	r3 = x + 32768;
+	r4 = x + 65535;
+	return 0;
+}
+
+int subImm(){
+	r1 = x - -32768;
+	r2 = x - 32767;
+	r3 = x - 32768;
+	r4 = x - 65535;
+	return 0;
+}
+
+int andImm(){
+	r1 = x & -32768;
+	r2 = x & 32767;
+	r3 = x & 32768;
+	r4 = x & 65535;
+	return 0;
+}
+
+int orImm(){
+	r1 = x | -32768;
+	r2 = x | 32767;
+	r3 = x | 32768;
+	r4 = x | 65535;
+	return 0;
+}
+
+int xorImm(){
+	r1 = x ^ -32768;
+	r2 = 32767 ^ x;
+	r3 = x ^ 32768;
+	r4 = 65535 ^ x;
+	return 0;
+}
+
+int lessImm(){
+	r1 = x < -32768;
+	r2 = x < 32767;
+	r3 = x < 32768;
+	r4 = x < 65535;
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*driver for test case immediates: x op c for c at the edges of the 16 bit immediates, expected values from gcc*/
+
+int addImm();
+int subImm();
+int andImm();
+int orImm();
+int xorImm();
+int lessImm();
+extern int x;
+extern int r1;
+extern int r2;
+extern int r3;
+extern int r4;
+
+int main(){
+	x = -1;
+	addImm();
+	if(r1!=-32769 || r2!=32766 || r3!=32767 || r4!=65534){
+		return 1;
+	}
+	subImm();
+	if(r1!=32767 || r2!=-32768 || r3!=-32769 || r4!=-65536){
+		return 2;
+	}
+	andImm();
+	if(r1!=-32768 || r2!=32767 || r3!=32768 || r4!=65535){
+		return 3;
+	}
+	orImm();
+	if(r1!=-1 || r2!=-1 || r3!=-1 || r4!=-1){
+		return 4;
+	}
+	xorImm();
+	if(r1!=32767 || r2!=-32768 || r3!=-32769 || r4!=-65536){
+		return 5;
+	}
+	lessImm();
+	if(r1!=0 || r2!=1 || r3!=1 || r4!=1){
+		return 6;
+	}
+	x = 32767;
+	addImm();
+	if(r1!=-1 || r2!=65534 || r3!=65535 || r4!=98302){
+		return 7;
+	}
+	subImm();
+	if(r1!=65535 || r2!=0 || r3!=-1 || r4!=-32768){
+		return 8;
+	}
+	andImm();
+	if(r1!=0 || r2!=32767 || r3!=0 || r4!=32767){
+		return 9;
+	}
+	orImm();
+	if(r1!=-1 || r2!=32767 || r3!=65535 || r4!=65535){
+		return 10;
+	}
+	xorImm();
+	if(r1!=-1 || r2!=0 || r3!=65535 || r4!=32768){
+		return 11;
+	}
+	lessImm();
+	if(r1!=0 || r2!=0 || r3!=1 || r4!=1){
+		return 12;
+	}
+	x = -32769;
+	addImm();
+	if(r1!=-65537 || r2!=-2 || r3!=-1 || r4!=32766){
+		return 13;
+	}
+	subImm();
+	if(r1!=-1 || r2!=-65536 || r3!=-65537 || r4!=-98304){
+		return 14;
+	}
+	andImm();
+	if(r1!=-65536 || r2!=32767 || r3!=0 || r4!=32767){
+		return 15;
+	}
+	orImm();
+	if(r1!=-1 || r2!=-32769 || r3!=-1 || r4!=-1){
+		return 16;
+	}
+	xorImm();
+	if(r1!=65535 || r2!=-65536 || r3!=-1 || r4!=-32768){
+		return 17;
+	}
+	lessImm();
+	if(r1!=1 || r2!=1 || r3!=1 || r4!=1){
+		return 18;
+	}
+	return 0;
+}
@@ -0,0 +1,41 @@
+/* the right of && and || is only evaluated when the left does not decide it, calls included */
+
+int count;
+
+int bump(){
+	count = count + 1;
+	return 1;
+}
+
+int skipAnd(){
+	int zero = 0;
+	return zero && bump(); /* 0, bump not called */
+}
+
+int callAnd(){
+	int one = 1;
+	return one && bump(); /* 1, bump called once */
+}
+
+int skipOr(){
+	int one = 1;
+	return one || bump(); /* 1, bump not called */
+}
+
+int callOr(){
+	int zero = 0;
+	return zero || bump(); /* 1, bump called once */
+}
+
+int skipConstant(){
+	return 0 && bump() || 1 || bump(); /* 1, bump not called */
+}
+
+int nested(){
+	int zero = 0;
+	int x = 0;
+	if(zero && bump() || bump() && zero){
+		x = 5;
+	}
+	return x; /* 0, bump called once, by the second && */
+}
@@ -0,0 +1,31 @@
+/*driver for test case short_circuit: count goes up each time bump is called*/
+
+int skipAnd();
+int callAnd();
+int skipOr();
+int callOr();
+int skipConstant();
+int nested();
+extern int count;
+
+int main(){
+	if(skipAnd()!=0 || count!=0){
+		return 1;
+	}
+	if(callAnd()!=1 || count!=1){
+		return 2;
+	}
+	if(skipOr()!=1 || count!=1){
+		return 3;
+	}
+	if(callOr()!=1 || count!=2){
+		return 4;
+	}
+	if(skipConstant()!=1 || count!=2){
+		return 5;
+	}
+	if(nested()!=0 || count!=3){
+		return 6;
+	}
+	return 0;
+}
@@ -0,0 +1,31 @@
+/* more values live at once than there are registers, with calls in the middle of them */
+
+int seven(){
+	return 7;
+}
+
+int spill(){
+	int a = seven();
+	int b = a + 1;
+	int c = b + a;
+	int d = c + b;
+	int e = d + c;
+	int f = e - d;
+	int g = f + e;
+	int h = g - a;
+	int i = h + b;
+	int j = i - c;
+	int k = j + d;
+	int l = k - e;
+	int m = l + f;
+	int n = m - g;
+	int o = n + h;
+	int p = o - i;
+	int q = p + j;
+	int r = q - k;
+	int s = r + l;
+	int t = s - m;
+	int x = seven(); /* every one of a to t is still needed after this */
+	x = x + (a + b * c) * seven() + d; /* and a temporary is live across the call */
+	return a + b + c + d + e + f + g + h + i + j + k + l + m + n + o + p + q + r + s + t + x + (s - t) * (q - r) + (o - p) * (m - n);
+}
@@ -0,0 +1,7 @@
+/*driver for test case spill: more than 16 values live at once, and calls while they are*/
+
+int spill();
+
+int main(){
+	return spill()!=6509; /* worked out by gcc */
+}
@@ -0,0 +1,70 @@
+/* while loops are rotated, with the test at the bottom, and branch on the inverse of their condition */
+
+int calls;
+
+int next(){
+	calls = calls + 1;
+	return calls;
+}
+
+int zeroTrip(){
+	int x = 10;
+	int n = 0;
+	while(x < 5){
+		n = n + 1;
+		x = x + 1;
+	}
+	while(0){
+		n = n + 100;
+	}
+	return n * 100 + x; /* 10, neither body runs */
+}
+
+int andCondition(){
+	int i = 0;
+	int j = 10;
+	while(i < 10 && j > 3){
+		i = i + 1;
+		j = j - 1;
+	}
+	return i * 100 + j; /* 703 */
+}
+
+int orCondition(){
+	int i = 0;
+	int j = 0;
+	while(i < 3 || j < 5){
+		i = i + 1;
+		j = j + 2;
+	}
+	return i * 100 + j; /* 306 */
+}
+
+int callCondition(){
+	int n = 0;
+	while(next() < 4 && n < 10){
+		n = n + 1;
+	}
+	return n * 100 + calls; /* 304, next is called once more to end the loop */
+}
+
+int nested(){
+	int i = 0;
+	int total = 0;
+	while(i < 4){
+		int j = 0;
+		while(j < i){
+			int k = 0;
+			while(k < 3 || k == j + 1){
+				total = total + 1;
+				k = k + 1;
+			}
+			j = j + 1;
+		}
+		while(i > 100){
+			total = total + 1000;
+		}
+		i = i + 1;
+	}
+	return total; /* 19: the inner loop runs 6 times, 3 times each, and once more when j is 2 */
+}
@@ -0,0 +1,11 @@
+/*driver for test case while_loops: loops that never run, conditions with && and || and calls, and loops in loops*/
+
+int zeroTrip();
+int andCondition();
+int orCondition();
+int callCondition();
+int nested();
+
+int main(){
+	return zeroTrip()!=10 || andCondition()!=703 || orCondition()!=306 || callCondition()!=304 || nested()!=19;
+}